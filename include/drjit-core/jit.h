@@ -165,6 +165,60 @@ extern JIT_EXPORT void jit_sync_device();
 /// Wait for all computation on the *all devices* to finish
 extern JIT_EXPORT void jit_sync_all_devices();
 
+/**
+ * \brief Create an event that tracks the completion of previously submitted work
+ *
+ * When \c index is zero, the event completes once all computation submitted
+ * by the calling thread to the queue of the given backend has finished.
+ * Otherwise, it completes when the contents of variable \c index are
+ * available. The variable is evaluated first if needed.
+ *
+ * On the LLVM backend, kernels of a task queue run in submission order, hence
+ * the event waits for the kernels that produced the variable along with all
+ * work that was queued before them. It does not wait for work that was
+ * submitted afterwards or to other task queues (e.g., by threads bound to a
+ * separate pool via \ref jit_llvm_set_pool()), which can be significantly
+ * cheaper than \ref jit_sync_thread() when such work is still in flight. When
+ * the origin of the variable is unknown, the event conservatively waits for
+ * the current position of every queue. On the CUDA backend, it completes once
+ * the stream of the calling thread has reached its current position.
+ *
+ * The returned handle must be released using \ref jit_event_destroy().
+ */
+extern JIT_EXPORT void *jit_event_record(JIT_ENUM JitBackend backend,
+                                         uint32_t index JIT_DEF(0));
+
+/// Check if an event has completed without blocking (1: yes, 0: no)
+extern JIT_EXPORT int jit_event_query(void *event);
+
+/// Wait for an event to complete
+extern JIT_EXPORT void jit_event_wait(void *event);
+
+/// Release an event created by \ref jit_event_record()
+extern JIT_EXPORT void jit_event_destroy(void *event);
+
+/**
+ * \brief Insert a host callback into the stream of asynchronous work
+ *
+ * This function enqueues <tt>callback(payload)</tt> so that it runs on the
+ * host once the computation producing the variables
+ * <tt>deps[0..dep_count-1]</tt> (which are evaluated first, if needed) as well
+ * as all work previously submitted by the calling thread has finished.
+ * Subsequent work of the calling thread is ordered after the callback. The
+ * function returns immediately, which makes it possible to e.g. overlap I/O
+ * and logging with tracing and evaluation of further computation.
+ *
+ * On the LLVM backend, the callback runs as a task in the thread pool. On the
+ * CUDA backend, it is enqueued via \c cuLaunchHostFunc(), and it may not call
+ * any CUDA API functions. In both cases, the callback should not call Dr.Jit
+ * functions that wait for the completion of computation.
+ */
+extern JIT_EXPORT void jit_enqueue_host_func(JIT_ENUM JitBackend backend,
+                                             void (*callback)(void *),
+                                             void *payload,
+                                             const uint32_t *deps JIT_DEF(0),
+                                             uint32_t dep_count JIT_DEF(0));
+
 // ====================================================================
 //                    CUDA/LLVM-specific functionality
 // ====================================================================
@@ -224,6 +278,30 @@ extern JIT_EXPORT int jit_cuda_compute_capability();
 extern JIT_EXPORT void jit_cuda_set_target(uint32_t ptx_version,
                                            uint32_t compute_capability);
 
+/**
+ * \brief Emulate a CUDA device to generate PTX code on machines without a GPU
+ *
+ * When this function is called with a nonzero \c compute_capability (e.g.
+ * '86') before the CUDA backend is initialized, \ref jit_init() replaces the
+ * CUDA driver by a host-side emulation of a single device with the specified
+ * compute capability. The optional \c ptx_version (e.g. '71') overrides the
+ * PTX version that would normally be chosen for this compute capability.
+ *
+ * Programs can then trace and evaluate CUDA arrays as usual. The generated
+ * PTX code is written to the kernel cache, but kernels never run: the
+ * contents of computed arrays are undefined. A subsequent \ref
+ * jit_kernel_pack_write() call bundles the cache into an archive that
+ * machines with a real GPU can load to skip the code generation step (the
+ * driver still compiles the PTX code when it is first loaded).
+ *
+ * Passing \c 0 for \c compute_capability switches back to the real driver.
+ * The function raises an exception when the CUDA backend is already active,
+ * in which case a prior call to <tt>jit_shutdown(0)</tt> is required. This
+ * feature is only available in builds that load the CUDA driver dynamically.
+ */
+extern JIT_EXPORT void jit_cuda_set_virtual_device(uint32_t ptx_version,
+                                                   uint32_t compute_capability);
+
 /// Look up an CUDA driver function by name
 extern JIT_EXPORT void *jit_cuda_lookup(const char *name);
 
@@ -265,6 +343,173 @@ extern JIT_EXPORT uint32_t jit_llvm_vector_width();
 /// Specify the number of threads that are used to parallelize the computation
 extern JIT_EXPORT void jit_llvm_set_thread_count(uint32_t size);
 
+/**
+ * \brief Return the number of NUMA nodes with at least one CPU
+ *
+ * This is relevant in combination with \ref JitFlag::NumaAffinity. The
+ * function returns 1 if the topology could not be determined (e.g. on
+ * platforms other than Linux).
+ */
+extern JIT_EXPORT uint32_t jit_llvm_numa_node_count();
+
+/**
+ * \brief Priority classes of work submitted to the LLVM backend
+ *
+ * See \ref jit_llvm_set_priority() for details.
+ */
+#if defined(__cplusplus)
+enum class JitPriority : uint32_t {
+    /// Background work that should only use otherwise idle cores
+    Low = 0,
+
+    /// Default priority: work runs in the shared thread pool
+    Normal = 1,
+
+    /// Latency-critical work
+    High = 2
+};
+#else
+enum JitPriority {
+    JitPriorityLow    = 0,
+    JitPriorityNormal = 1,
+    JitPriorityHigh   = 2
+};
+#endif
+
+/**
+ * \brief Set the priority class of LLVM work submitted by the calling thread
+ *
+ * By default, kernels launched by all threads enter a single first-in
+ * first-out queue that is processed by one shared thread pool, which means
+ * that a small latency-critical launch has to wait for previously submitted
+ * large launches to finish. Calling this function with a priority other than
+ * \c JitPriority::Normal moves the calling thread to a separate queue and
+ * thread pool associated with the priority class. Each of these pools
+ * receives a quarter of the cores, which are taken from the shared pool to
+ * avoid oversubscription. Worker threads of the \c Low pool run with the OS
+ * scheduling policy for idle/background tasks, and those of the \c High pool
+ * request an elevated scheduling priority. The latter requires additional
+ * privileges (\c CAP_SYS_NICE on Linux); otherwise, a warning is logged and
+ * the workers run with the default priority. The OS scheduler will then
+ * preempt lower-priority workers in favor of higher-priority ones.
+ *
+ * The function waits for previously submitted work of the calling thread to
+ * finish before switching.
+ *
+ * Note that the queues of different priority classes are not ordered with
+ * respect to each other. When a thread with a non-default priority accesses
+ * variables that were evaluated by another thread (or vice versa), the
+ * producer must first call \ref jit_sync_thread().
+ */
+extern JIT_EXPORT void jit_llvm_set_priority(JIT_ENUM JitPriority priority);
+
+/// Return the priority class of LLVM work submitted by the calling thread
+extern JIT_EXPORT JIT_ENUM JitPriority jit_llvm_priority();
+
+/**
+ * \brief Create a separate thread pool for the LLVM backend
+ *
+ * By default, all threads using the LLVM backend share one pool, whose size
+ * is set via \ref jit_llvm_set_thread_count(). In multi-tenant applications,
+ * one tenant's large kernel can then occupy all cores. This function creates
+ * an additional pool with \c thread_count workers and returns its ID (a
+ * nonzero value). Use \ref jit_llvm_set_pool() to bind threads to it.
+ */
+extern JIT_EXPORT uint32_t jit_llvm_pool_create(uint32_t thread_count);
+
+/**
+ * \brief Destroy a pool created via \ref jit_llvm_pool_create()
+ *
+ * Raises an exception when threads are still bound to the pool.
+ */
+extern JIT_EXPORT void jit_llvm_pool_destroy(uint32_t id);
+
+/**
+ * \brief Bind the calling thread to an LLVM thread pool
+ *
+ * Subsequent LLVM kernels launched by the calling thread will run in the
+ * pool with ID \c id, where \c 0 refers to the shared default pool. Threads
+ * bound to a separate pool have a private task queue, hence the remarks in
+ * \ref jit_llvm_set_priority() regarding synchronization apply. This
+ * resets the priority class of the calling thread to \c JitPriority::Normal.
+ * The function waits for previously submitted work of the calling thread to
+ * finish before switching.
+ */
+extern JIT_EXPORT void jit_llvm_set_pool(uint32_t id);
+
+/// Return the ID of the pool used by LLVM work submitted by the calling thread
+extern JIT_EXPORT uint32_t jit_llvm_pool();
+
+/// Utilization statistics of an LLVM thread pool (see \ref jit_llvm_pool_stats())
+struct LLVMPoolStats {
+    /// Number of worker threads
+    uint32_t thread_count;
+
+    /// Number of threads that are bound to the pool
+    uint32_t bound_count;
+
+    /// Number of kernels and other parallel operations launched into the pool
+    uint64_t launches;
+
+    /// Number of processed work units
+    uint64_t work_units;
+
+    /// Time (ms) spent processing work units, summed over all workers
+    double busy_time;
+
+    /// Time (ms) elapsed since the pool was created
+    double wall_time;
+
+    /// Fraction of the available worker time spent processing work units
+    double utilization;
+};
+
+/**
+ * \brief Query utilization statistics of an LLVM thread pool
+ *
+ * The ID \c 0 refers to the shared default pool. Work units that a thread
+ * processes while waiting for its own tasks are attributed to the pool that
+ * it is bound to (see \ref jit_llvm_set_pool()).
+ */
+extern JIT_EXPORT void jit_llvm_pool_stats(uint32_t id,
+                                           struct LLVMPoolStats *stats);
+
+/**
+ * \brief Return the cancellation token of the calling thread
+ *
+ * The returned handle can be passed to \ref jit_llvm_cancel() from any
+ * thread. It remains valid until \ref jit_shutdown() is called.
+ */
+extern JIT_EXPORT void *jit_llvm_cancel_token();
+
+/**
+ * \brief Cancel LLVM kernels launched by the owner of \c token
+ *
+ * Kernels are split into work units that are processed in parallel. After
+ * this function is called, work units of kernels that were launched by the
+ * owner of \c token before the call are skipped, which quickly frees up the
+ * thread pool. Kernels launched afterwards are unaffected. The function can
+ * be called from any thread and does not block.
+ *
+ * Variables evaluated by a cancelled kernel have undefined contents. The
+ * next call to \ref jit_sync_thread(), \ref jit_sync_device(), \ref
+ * jit_sync_all_devices(), or \ref jit_eval() by the owner of the token raises
+ * an exception to report the cancellation. Implicit synchronization within
+ * other operations (e.g., when reading variable contents or performing
+ * horizontal reductions) is not interrupted and does not raise.
+ */
+extern JIT_EXPORT void jit_llvm_cancel(void *token);
+
+/**
+ * \brief Set a deadline for LLVM kernels launched by the calling thread
+ *
+ * Work units that start more than \c timeout_ms milliseconds after this
+ * call are skipped, as if \ref jit_llvm_cancel() had been called. This
+ * remains in effect until the deadline is changed. Passing \c 0 disables
+ * the deadline.
+ */
+extern JIT_EXPORT void jit_llvm_set_deadline(float timeout_ms);
+
 // ====================================================================
 //                        Logging infrastructure
 // ====================================================================
@@ -430,9 +675,39 @@ extern JIT_EXPORT void jit_flush_malloc_cache();
 /// Clear the peak memory usage statistics
 extern JIT_EXPORT void jit_malloc_clear_statistics();
 
+/**
+ * \brief Return the peak amount of memory of the given type that was held by
+ * the allocator (including its cache) since the last call to \ref
+ * jit_malloc_clear_statistics()
+ */
+extern JIT_EXPORT size_t jit_malloc_watermark(JIT_ENUM AllocType type);
+
 /// Flush internal kernel cache
 extern JIT_EXPORT void jit_flush_kernel_cache();
 
+/**
+ * \brief Bundle the kernels used by this process into a single file
+ *
+ * Compiled kernels are normally stored in individual files of the cache
+ * directory (e.g. <tt>~/.drjit</tt>). This function collects the entries of all
+ * kernels that were compiled or loaded by the current process (e.g., during a
+ * warm-up run) and writes them to a single file with a lookup table at the
+ * beginning. A deployed application can load this file using \ref
+ * jit_kernel_pack_load() or by setting the environment variable \c
+ * DRJIT_KERNEL_PACK before calling \ref jit_init(). Kernels contained in the
+ * pack are then found without running the LLVM/PTX compiler and without
+ * accessing the cache directory. Returns the number of bundled kernels.
+ *
+ * Packs are tied to the Dr.Jit version and to the machine configuration
+ * (e.g. CPU features, vector width) that produced them. Kernels that are
+ * missing from the pack are compiled as usual. If a pack entry cannot be
+ * loaded, the kernel is looked up in the cache directory instead.
+ */
+extern JIT_EXPORT uint32_t jit_kernel_pack_write(const char *path);
+
+/// Load a file created by \ref jit_kernel_pack_write() (\c NULL: unload)
+extern JIT_EXPORT void jit_kernel_pack_load(const char *path);
+
 /// Query the flavor of a memory allocation made using \ref jit_malloc()
 extern JIT_EXPORT JIT_ENUM AllocType jit_malloc_type(void *ptr);
 
@@ -978,6 +1253,134 @@ extern JIT_EXPORT uint32_t jit_var_mem_map(JIT_ENUM JitBackend backend,
                                            JIT_ENUM VarType type, void *ptr,
                                            size_t size, int free);
 
+/**
+ * \brief Access hints for memory-mapped files
+ *
+ * See \ref jit_var_mem_map_file() for details.
+ */
+#if defined(__cplusplus)
+enum class MemAdvice : uint32_t {
+    /// Start with the OS default, and switch to \c Random upon a gather
+    Auto = 0,
+
+    /// Use the OS default read-ahead policy
+    Normal = 1,
+
+    /// The data will be read front to back (aggressive read-ahead)
+    Sequential = 2,
+
+    /// The data will be accessed in random order (no read-ahead)
+    Random = 3,
+
+    /// Start loading the entire region in the background
+    WillNeed = 4
+};
+#else
+enum MemAdvice {
+    MemAdviceAuto       = 0,
+    MemAdviceNormal     = 1,
+    MemAdviceSequential = 2,
+    MemAdviceRandom     = 3,
+    MemAdviceWillNeed   = 4
+};
+#endif
+
+/**
+ * \brief Map a region of a file into memory and return a variable that
+ * references it. Its reference count is initialized to \c 1.
+ *
+ * On the LLVM backend, the variable directly references the pages of the
+ * file, which are loaded on demand by the OS. This avoids reading multi-GB
+ * datasets into memory before the first kernel can run, and pages that are
+ * never accessed are never loaded. The mapping is private: in-place
+ * modifications of the variable (e.g. via \ref jit_var_scatter()) affect a
+ * private copy of the touched pages and leave the file unchanged. The region
+ * is unmapped when the variable is freed, once previously launched kernels
+ * have finished. The file should not be truncated while it is mapped.
+ *
+ * On the CUDA backend, the region is mapped temporarily and uploaded to the
+ * device.
+ *
+ * \param path
+ *    Path of the file
+ *
+ * \param offset
+ *    Byte offset of the region within the file. It does not need to be
+ *    page-aligned, but an offset that is not a multiple of the alignment
+ *    expected by vectorized kernels leads to slower unaligned loads.
+ *
+ * \param type
+ *    Type of the variable to be created, see \ref VarType for details.
+ *
+ * \param count
+ *    Number of elements (and *not* the size in bytes). The value \c 0 maps
+ *    the remainder of the file.
+ *
+ * \param advice
+ *    Access hint that is forwarded to the OS via \c madvise(). The default
+ *    (\c MemAdvice::Auto) switches to random access when the variable is
+ *    first used as the source of a gather operation.
+ *
+ * \sa jit_var_mem_map()
+ */
+extern JIT_EXPORT uint32_t
+jit_var_mem_map_file(JIT_ENUM JitBackend backend, const char *path,
+                     size_t offset, JIT_ENUM VarType type, size_t count,
+                     JIT_ENUM MemAdvice advice JIT_DEF(MemAdvice::Auto));
+
+/**
+ * \brief Export an evaluated host array to other processes
+ *
+ * The variable is evaluated and copied into host memory that is backed by an
+ * in-memory file (created via \c memfd_create()). The function returns a new
+ * variable referencing this copy (with a reference count of \c 1) and writes
+ * a file descriptor that refers to its contents to \c fd. The descriptor
+ * remains owned by the returned variable and is closed when its memory is
+ * released. Another process on the same machine can receive it (e.g. via \c
+ * SCM_RIGHTS over a UNIX domain socket, or by opening
+ * <tt>/proc/[pid]/fd/[fd]</tt>) and pass it to \ref jit_var_import_fd() to
+ * access the array without copying. If \c index already refers to shareable
+ * memory (e.g. a variable returned by a previous call), no copy is made: the
+ * function increases the reference count of \c index and returns it along
+ * with the existing descriptor.
+ *
+ * The input variable is left unchanged, hence existing references to its
+ * memory (e.g. via \ref jit_var_data()) remain valid. The returned array is
+ * shared and must not be modified in place (e.g. via \ref jit_var_scatter())
+ * while other processes access it. Only supported by the LLVM backend on
+ * Linux.
+ *
+ * \sa jit_var_import_fd()
+ */
+extern JIT_EXPORT uint32_t jit_var_export_fd(uint32_t index, int *fd);
+
+/**
+ * \brief Create a variable that references an array exported by another
+ * process via \ref jit_var_export_fd(). Its reference count is initialized
+ * to \c 1.
+ *
+ * On the LLVM backend, the variable privately maps the shared file, hence no
+ * data is copied. In-place modifications affect a private copy of the touched
+ * pages and are not visible to the exporting process. The function does not
+ * take ownership of \c fd, which may be closed once it returns. On the CUDA
+ * backend, the contents are uploaded to the device.
+ *
+ * \param fd
+ *    File descriptor referring to the shared array
+ *
+ * \param type
+ *    Type of the variable to be created, see \ref VarType for details.
+ *
+ * \param count
+ *    Number of elements (and *not* the size in bytes). The value \c 0 maps
+ *    the entire file, which may include padding at the end.
+ *
+ * \sa jit_var_export_fd()
+ */
+extern JIT_EXPORT uint32_t jit_var_import_fd(JIT_ENUM JitBackend backend,
+                                             int fd, JIT_ENUM VarType type,
+                                             size_t count);
+
 /**
  * Copy a memory region onto the device and return its variable index. Its
  * reference count is initialized to \c 1.
@@ -1005,6 +1408,132 @@ extern JIT_EXPORT uint32_t jit_var_mem_copy(JIT_ENUM JitBackend backend,
                                             const void *ptr,
                                             size_t size);
 
+/// Describes an input of \ref jit_stream()
+struct StreamInput {
+    /// Type of the input
+    JIT_ENUM VarType type;
+
+    /**
+     * \brief Callback that writes elements <tt>[start, start + count)</tt> of
+     * the input to the host buffer \c dst. Invoked without holding the lock.
+     */
+    void (*read)(void *payload, size_t start, uint32_t count, void *dst);
+
+    /// Payload of \c read
+    void *payload;
+
+    /// Alternatively (if \c read is \c NULL): file containing a flat array
+    const char *path;
+
+    /// Byte offset of the array within the file at \c path
+    size_t offset;
+};
+
+/**
+ * \brief Evaluate a computation over inputs that don't fit into memory
+ *
+ * This function splits the inputs (each with \c size elements) into chunks of
+ * \c chunk_size elements (or a default size if \c 0 is specified), and then
+ * invokes <tt>body(payload, start, count, in)</tt> for each chunk. Here, \c in
+ * lists \c input_count variables holding elements <tt>[start, start +
+ * count)</tt> of the inputs, and \c body should trace a computation whose
+ * results are accumulated via side effects (e.g., \ref jit_var_scatter() with
+ * \c ReduceOp::Add, which also works for reductions into single-element
+ * arrays). Following each call, the side effects are evaluated.
+ *
+ * Note that \c body is invoked, and the computation therefore traced, once
+ * per chunk: this function does not record a kernel for replay. Tracing and
+ * kernel assembly thus incur a per-chunk cost that should be amortized by
+ * using a sufficiently large \c chunk_size. Compilation, by contrast, normally
+ * only happens once: the kernels of different chunks only differ in their
+ * size, and are therefore found in the kernel cache after the first chunk.
+ * This requires that \c body doesn't bake chunk-dependent values (such as \c
+ * start) into the trace as literals, which would yield a new kernel per chunk.
+ *
+ * Chunk data is stored in two sets of buffers that are used in alternation:
+ * while the kernels of one chunk run asynchronously, the data of the next
+ * chunk is read into the other set of buffers.
+ *
+ * The variables in \c in are released after each call. They should normally
+ * not be referenced beyond it, otherwise a new buffer must be allocated for
+ * the next chunk. The function returns once all chunks have been read; their
+ * computation may still be in progress (use \ref jit_sync_thread() to wait).
+ */
+extern JIT_EXPORT void
+jit_stream(JIT_ENUM JitBackend backend, size_t size, uint32_t chunk_size,
+           uint32_t input_count, const struct StreamInput *inputs,
+           void (*body)(void *payload, size_t start, uint32_t count,
+                        const uint32_t *in),
+           void *payload);
+
+/**
+ * \brief Write the contents of a variable to a file
+ *
+ * The variable is evaluated, and its type, size, and backend are stored along
+ * with its contents. The data is split into chunks of 4 MiB that are
+ * compressed with LZ4 in parallel, and each chunk carries a checksum that is
+ * validated by \ref jit_var_load().
+ */
+extern JIT_EXPORT void jit_var_save(uint32_t index, const char *path);
+
+/**
+ * \brief Load a variable from a file written by \ref jit_var_save()
+ *
+ * The variable is created on the backend it was saved from, and its reference
+ * count is initialized to \c 1. Chunks are decompressed in parallel. On the
+ * LLVM backend, this happens directly in the memory that is subsequently
+ * owned by the variable.
+ */
+extern JIT_EXPORT uint32_t jit_var_load(const char *path);
+
+/**
+ * \brief Convert an array of records ("array of structures") into separate
+ * variables per field ("structure of arrays")
+ *
+ * \param src
+ *    Host memory containing \c count records, where record \c i starts at
+ *    address <tt>src + i * stride</tt>.
+ *
+ * \param types
+ *    Types of the \c field_count fields.
+ *
+ * \param offsets
+ *    Byte offsets of the fields within each record.
+ *
+ * \param out
+ *    Receives the indices of \c field_count newly created variables of size
+ *    \c count, whose reference count is initialized to \c 1.
+ *
+ * All fields are converted in a single parallel pass. On the LLVM backend,
+ * this involves a cache-blocked transpose using the thread pool. On the CUDA
+ * backend, the records are uploaded in one transfer and split by one kernel
+ * (if the fields are naturally aligned, and otherwise on the host). The
+ * memory region \c src may be released once the function returns.
+ */
+extern JIT_EXPORT void jit_aos_to_soa(JIT_ENUM JitBackend backend,
+                                      const void *src, size_t stride,
+                                      uint32_t count, uint32_t field_count,
+                                      const JIT_ENUM VarType *types,
+                                      const size_t *offsets, uint32_t *out);
+
+/**
+ * \brief Interleave variables into an array of records (the reverse of \ref
+ * jit_aos_to_soa())
+ *
+ * Writes field \c j of record \c i with the contents of variable
+ * <tt>in[j]</tt> at position \c i to the address <tt>dst + i * stride +
+ * offsets[j]</tt>. The variables must have the same size or size 1 (in which
+ * case their value is replicated). The memory region \c dst must be large
+ * enough to hold all records, and the contents of bytes that are not covered
+ * by any field are unspecified. Returns the number of written records. The
+ * function blocks until the conversion has finished.
+ */
+extern JIT_EXPORT uint32_t jit_soa_to_aos(JIT_ENUM JitBackend backend,
+                                          void *dst, size_t stride,
+                                          uint32_t field_count,
+                                          const uint32_t *in,
+                                          const size_t *offsets);
+
 /// Increase the reference count of a given variable
 extern JIT_EXPORT void jit_var_inc_ref_impl(uint32_t index) JIT_NOEXCEPT;
 
@@ -1048,6 +1577,14 @@ extern JIT_EXPORT int jit_var_is_literal(uint32_t index);
 /// Check if a variable is evaluated
 extern JIT_EXPORT int jit_var_is_evaluated(uint32_t index);
 
+/**
+ * \brief Check if a variable is evaluated *and* the kernels computing it have
+ * finished, i.e., whether its contents can be accessed without blocking.
+ *
+ * Unlike \ref jit_event_record(), this function never triggers an evaluation.
+ */
+extern JIT_EXPORT int jit_var_ready(uint32_t index);
+
 /// Check if a variable is a special placeholder value used to record computation
 extern JIT_EXPORT int jit_var_is_placeholder(uint32_t index);
 
@@ -1137,6 +1674,44 @@ extern JIT_EXPORT void jit_var_read(uint32_t index, size_t offset,
 extern JIT_EXPORT uint32_t jit_var_write(uint32_t index, size_t offset,
                                          const void *src);
 
+/**
+ * \brief Fetch several entries of a variable at once
+ *
+ * This function reads the entries at the positions <tt>offsets[0..count-1]</tt>
+ * of the variable with index \c index and writes them to consecutive positions
+ * of the CPU output buffer \c dst. In contrast to repeated calls to \ref
+ * jit_var_read(), it only waits for the computation producing the variable
+ * (not for work submitted afterwards, see \ref jit_event_record()) and
+ * transfers all entries using a single gather operation.
+ */
+extern JIT_EXPORT void jit_var_read_many(uint32_t index, const size_t *offsets,
+                                         uint32_t count, void *dst);
+
+/**
+ * \brief Asynchronous version of \ref jit_var_read_many()
+ *
+ * The function returns immediately. The contents of \c dst are available once
+ * the returned event has completed (see \ref jit_event_wait()). The event
+ * must be released using \ref jit_event_destroy().
+ */
+extern JIT_EXPORT void *jit_var_read_many_async(uint32_t index,
+                                                const size_t *offsets,
+                                                uint32_t count, void *dst);
+
+/**
+ * \brief Copy several elements to a variable at once
+ *
+ * This function implements the reverse of \ref jit_var_read_many(). The
+ * entries are written using a single scatter operation. Like \ref
+ * jit_var_write(), the function returns the index of a new array (which may
+ * happen to be identical to \c index), whose reference count is increased by
+ * 1. When an offset occurs multiple times, it is unspecified which of the
+ * associated values is written.
+ */
+extern JIT_EXPORT uint32_t jit_var_write_many(uint32_t index,
+                                              const size_t *offsets,
+                                              uint32_t count, const void *src);
+
 /**
  * \brief Print the specified variable contents from the kernel
  *
@@ -1334,6 +1909,24 @@ enum class JitFlag : uint32_t {
     /// Perform a intra-warp/SIMD register reduction before issuing global atomics
     AtomicReduceLocal = 16384,
 
+    /**
+     * \brief Pin LLVM worker threads to NUMA nodes, first-touch large
+     * host-asynchronous allocations in parallel, and assign contiguous ranges
+     * of work units to the node that owns the associated memory. This flag
+     * has no effect on machines with a single NUMA node.
+     */
+    NumaAffinity = 32768,
+
+    /**
+     * \brief Store kernel outputs in the buffer of an input that is no longer
+     * needed afterwards (e.g. <tt>x = x * 2 + 1</tt>), instead of allocating
+     * new memory. This only applies to inputs that are exclusively consumed
+     * by elementwise operations computing the output in question. Affected
+     * LLVM kernels can't declare their inputs and outputs as non-aliasing,
+     * which may reduce the quality of the generated code.
+     */
+    DonateBuffers = 65536,
+
     /// Default flags
     Default = (uint32_t) ConstProp | (uint32_t) ValueNumbering |
               (uint32_t) LoopRecord | (uint32_t) LoopOptimize |
@@ -1357,7 +1950,9 @@ enum JitFlag {
     JitFlagKernelHistory       = 2048,
     JitFlagLaunchBlocking      = 4096,
     JitFlagADOptimize          = 8192,
-    JitFlagAtomicReduceLocal = 16384
+    JitFlagAtomicReduceLocal = 16384,
+    JitFlagNumaAffinity      = 32768,
+    JitFlagDonateBuffers     = 65536
 };
 #endif
 
@@ -1736,6 +2331,32 @@ extern JIT_EXPORT void jit_block_copy(JIT_ENUM JitBackend backend, JIT_ENUM VarT
 extern JIT_EXPORT void jit_block_sum(JIT_ENUM JitBackend backend, JIT_ENUM VarType type,
                                      const void *in, void *out, uint32_t size,
                                      uint32_t block_size);
+
+/**
+ * \brief Sparse matrix-vector product with a matrix in compressed sparse row
+ * (CSR) format
+ *
+ * This function computes <tt>out = A x</tt>, where the matrix \c A has \c rows
+ * rows and \c nnz nonzero entries. The entries of row \c i are located at
+ * positions <tt>offsets[i]</tt> to <tt>offsets[i+1]-1</tt> of the arrays \c
+ * cols (column indices) and \c values (of type \c type, which must be \c
+ * Float32 or \c Float64). \c offsets must therefore contain <tt>rows + 1</tt>
+ * entries. The array \c x contains the input vector, and \c out must have
+ * space for \c rows elements.
+ *
+ * Each row is computed by a single thread without atomic operations. The rows
+ * are partitioned among the work units of the thread pool so that each unit
+ * processes a similar number of nonzero entries, which balances matrices
+ * with very irregular row lengths.
+ *
+ * Only supported by the LLVM backend. Runs asynchronously.
+ */
+extern JIT_EXPORT void jit_spmv_csr(JIT_ENUM JitBackend backend,
+                                    JIT_ENUM VarType type,
+                                    const uint32_t *offsets,
+                                    const uint32_t *cols, const void *values,
+                                    const void *x, void *out, uint32_t rows,
+                                    uint32_t nnz);
 /**
  * \brief Insert a function call to a ray tracing functor into the LLVM program
  *
@@ -1754,6 +2375,64 @@ extern JIT_EXPORT void jit_llvm_ray_trace(uint32_t func, uint32_t scene,
                                           int shadow_ray, const uint32_t *in,
                                           uint32_t *out);
 
+/**
+ * \brief Register a precompiled LLVM module whose functions can be called from
+ * traced code via \ref jit_llvm_call()
+ *
+ * The \c data argument should contain LLVM bitcode or textual IR with \c
+ * size bytes. The module is parsed immediately, and an exception is raised if
+ * this fails or if one of its functions was already registered by another
+ * module (registering the same module again has no effect). Kernels that
+ * call one of the functions receive a private copy of the module, which
+ * enables LLVM to inline the callee.
+ *
+ * The module should be self-contained (i.e., it should not reference external
+ * symbols besides LLVM intrinsics). Registered modules remain active until the
+ * LLVM backend is shut down.
+ */
+extern JIT_EXPORT void jit_llvm_register_module(const void *data, size_t size);
+
+/**
+ * \brief Call a function provided by a module that was registered via \ref
+ * jit_llvm_register_module()
+ *
+ * The callee must be a pure function operating on entire packets, i.e., with
+ * a signature like <tt><W x float> @name(<W x float>, <W x i32>)</tt>, where
+ * \c W equals \ref jit_llvm_vector_width(). Between one and four arguments
+ * (\c args) are supported, and the result has type \c type. Because the
+ * function is assumed to have no side effects, it may also be evaluated for
+ * inactive lanes, and repeated calls with the same arguments are collapsed.
+ * An exception is raised if the types of \c args and \c type (at the current
+ * vector width) don't match the signature of the callee.
+ *
+ * Returns the index of the resulting variable.
+ */
+extern JIT_EXPORT uint32_t jit_llvm_call(const char *name, JIT_ENUM VarType type,
+                                         uint32_t n_args, const uint32_t *args);
+
+/**
+ * \brief Multiply a vector in every lane by a shared matrix
+ *
+ * This operation computes <tt>out[i] = bias[i] + sum_j W[i * cols + j] *
+ * in[j]</tt> for <tt>i = 0 .. rows - 1</tt>, where \c W and \c bias refer to
+ * the arrays \c weights and \c bias (the latter is optional and may be set to
+ * zero). It is the building block of small neural networks that are evaluated
+ * within larger programs, where a sequence of such calls (interleaved with
+ * activation functions) realizes a multilayer perceptron.
+ *
+ * The \c weights and \c bias arrays must have type <tt>VarType::Float32</tt>
+ * or <tt>VarType::Float64</tt> and are evaluated by this function. The \c
+ * cols variables \c in must have the same type. Their indices are written to
+ * the \c rows entries of \c out.
+ *
+ * In contrast to an equivalent sequence of gathers and arithmetic operations,
+ * the LLVM backend generates a compact loop that loads each weight once per
+ * packet and broadcasts it across the SIMD lanes.
+ */
+extern JIT_EXPORT void jit_llvm_matvec(uint32_t weights, uint32_t bias,
+                                       uint32_t rows, uint32_t cols,
+                                       const uint32_t *in, uint32_t *out);
+
 /**
  * \brief Set a new scope identifier to limit the effect of common
  * subexpression elimination
@@ -1777,6 +2456,100 @@ extern JIT_EXPORT uint32_t jit_scope(JIT_ENUM JitBackend backend);
 /// Manually sets a scope identifier (see \ref jit_new_scope())
 extern JIT_EXPORT void jit_set_scope(JIT_ENUM JitBackend backend, uint32_t domain);
 
+// ====================================================================
+//            Arrays sharded across processes, collectives
+// ====================================================================
+
+/**
+ * \brief Transport callback used by the collective operations of the sharding
+ * layer
+ *
+ * Every rank of the group calls this function with the same \c size. It must
+ * block until all ranks have contributed their \c size bytes from \c in, and
+ * then write the contributions of all ranks (ordered by rank) to \c out,
+ * which has space for <tt>size * group size</tt> bytes. An implementation
+ * could, e.g., forward to \c MPI_Allgather(). \c size never exceeds 64 bytes.
+ */
+typedef void (*ShardAllGather)(const void *in, void *out, size_t size,
+                               void *payload);
+
+/**
+ * \brief Join a group of \c size processes as rank \c rank, using a custom
+ * transport for collective operations
+ *
+ * Each process of the group owns a slice of the logical arrays of a
+ * computation (see \ref jit_shard_slice()). The collective variants of
+ * reductions and prefix sums (\ref jit_reduce_all(), \ref jit_scan_u32_all(),
+ * \ref jit_var_reduce_all()) combine the partial results of all processes.
+ * They must be called by every rank in the same order. Without a group, the
+ * process forms a group of size 1, and the collectives reduce to their local
+ * counterparts.
+ */
+extern JIT_EXPORT void jit_shard_init(uint32_t rank, uint32_t size,
+                                      ShardAllGather func, void *payload);
+
+/**
+ * \brief Join a group of \c size processes on the same machine that
+ * communicate through a POSIX shared memory object named \c name
+ *
+ * All processes of the group must specify the same name and group size, and
+ * the function blocks until all of them have joined. The name should be
+ * unique per job; it is removed once the group is complete. When other
+ * processes don't arrive within 60 seconds (here or in a subsequent collective
+ * operation, e.g., because one of them crashed), an exception is raised. Only
+ * supported on Linux.
+ */
+extern JIT_EXPORT void jit_shard_init_shm(const char *name, uint32_t rank,
+                                          uint32_t size);
+
+/// Leave the current process group (see \ref jit_shard_init())
+extern JIT_EXPORT void jit_shard_shutdown();
+
+/// Return the rank of this process within its group
+extern JIT_EXPORT uint32_t jit_shard_rank();
+
+/// Return the number of processes of the group
+extern JIT_EXPORT uint32_t jit_shard_size();
+
+/**
+ * \brief Return the number of entries of a logical array with \c size
+ * entries that are owned by this process
+ *
+ * The array is split into contiguous slices of (almost) equal size in rank
+ * order. When \c offset is not \c nullptr, the function writes the position
+ * of the first owned entry within the logical array to it.
+ */
+extern JIT_EXPORT uint32_t jit_shard_slice(size_t size, size_t *offset);
+
+/**
+ * \brief Collective variant of \ref jit_reduce(): reduce the local slice and
+ * combine the result with those of all other ranks
+ *
+ * Every rank receives the reduction of the entire logical array in \c out.
+ * Ranks with an empty slice (<tt>size == 0</tt>) still participate.
+ * Synchronizes with the calling thread's queued work and with the other ranks.
+ */
+extern JIT_EXPORT void jit_reduce_all(JIT_ENUM JitBackend backend,
+                                      JIT_ENUM VarType type,
+                                      JIT_ENUM ReduceOp rtype, const void *ptr,
+                                      uint32_t size, void *out);
+
+/**
+ * \brief Collective variant of \ref jit_scan_u32(): compute an exclusive
+ * prefix sum of the logical array spanning the slices of all ranks
+ *
+ * The local prefix sum is offset by the sum of the slices of all preceding
+ * ranks. Returns the sum of the entire logical array. The same size
+ * requirements as in \ref jit_scan_u32() apply.
+ */
+extern JIT_EXPORT uint32_t jit_scan_u32_all(JIT_ENUM JitBackend backend,
+                                            const uint32_t *in, uint32_t size,
+                                            uint32_t *out);
+
+/// Collective variant of \ref jit_var_reduce(), see \ref jit_reduce_all()
+extern JIT_EXPORT uint32_t jit_var_reduce_all(uint32_t index,
+                                              JIT_ENUM ReduceOp reduce_op);
+
 // ====================================================================
 //                            Kernel History
 // ====================================================================
@@ -1854,6 +2627,27 @@ struct KernelHistoryEntry {
 
     /// nanothread task handle
     void *task;
+
+    // Roofline statistics (placed last to preserve the layout above)
+    // ================================================================
+
+    /**
+     * Estimated number of bytes read from memory: the size of the input
+     * arrays plus one element per lane for each gather
+     */
+    uint64_t bytes_read;
+
+    /// Estimated number of bytes written to memory (outputs and scatters)
+    uint64_t bytes_written;
+
+    /// Number of arithmetic operations across all lanes (an FMA counts as two)
+    uint64_t arithmetic_ops;
+
+    /// Arithmetic operations per byte of memory traffic
+    float arithmetic_intensity;
+
+    /// Achieved memory bandwidth (GB/s) based on \c execution_time
+    float bandwidth;
 };
 
 /// Clear the kernel history
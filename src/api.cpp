@@ -18,6 +18,13 @@
 #include "op.h"
 #include "vcall.h"
 #include "loop.h"
+#include "numa.h"
+#include "llvm_pool.h"
+#include "event.h"
+#include "mmap.h"
+#include "stream.h"
+#include "serialize.h"
+#include "shard.h"
 #include <thread>
 #include <condition_variable>
 #include <drjit-core/texture.h>
@@ -265,6 +272,12 @@ void jit_cuda_set_target(uint32_t ptx_version, uint32_t compute_capability) {
     ts->compute_capability = compute_capability;
 }
 
+void jit_cuda_set_virtual_device(uint32_t ptx_version,
+                                 uint32_t compute_capability) {
+    lock_guard guard(state.lock);
+    jitc_cuda_set_virtual_device(ptx_version, compute_capability);
+}
+
 void *jit_cuda_lookup(const char *name) {
     lock_guard guard(state.lock);
     return jitc_cuda_lookup(name);
@@ -274,6 +287,60 @@ void jit_llvm_set_thread_count(uint32_t size) {
     pool_set_size(nullptr, size);
 }
 
+uint32_t jit_llvm_numa_node_count() {
+    lock_guard guard(state.lock);
+    return jitc_numa_node_count();
+}
+
+void jit_llvm_set_priority(JitPriority priority) {
+    lock_guard guard(state.lock);
+    jitc_llvm_set_priority(priority);
+}
+
+JitPriority jit_llvm_priority() {
+    lock_guard guard(state.lock);
+    return jitc_llvm_priority();
+}
+
+uint32_t jit_llvm_pool_create(uint32_t thread_count) {
+    lock_guard guard(state.lock);
+    return jitc_llvm_pool_create(thread_count);
+}
+
+void jit_llvm_pool_destroy(uint32_t id) {
+    lock_guard guard(state.lock);
+    jitc_llvm_pool_destroy(id);
+}
+
+void jit_llvm_set_pool(uint32_t id) {
+    lock_guard guard(state.lock);
+    jitc_llvm_set_pool(id);
+}
+
+uint32_t jit_llvm_pool() {
+    lock_guard guard(state.lock);
+    return jitc_llvm_pool();
+}
+
+void jit_llvm_pool_stats(uint32_t id, LLVMPoolStats *stats) {
+    lock_guard guard(state.lock);
+    jitc_llvm_pool_stats(id, stats);
+}
+
+void *jit_llvm_cancel_token() {
+    lock_guard guard(state.lock);
+    return jitc_llvm_cancel_token();
+}
+
+void jit_llvm_cancel(void *token) {
+    jitc_llvm_cancel(token);
+}
+
+void jit_llvm_set_deadline(float timeout_ms) {
+    lock_guard guard(state.lock);
+    jitc_llvm_set_deadline(timeout_ms);
+}
+
 void jit_llvm_set_target(const char *target_cpu,
                          const char *target_features,
                          uint32_t vector_width) {
@@ -308,16 +375,46 @@ uint32_t jit_llvm_vector_width() {
 void jit_sync_thread() {
     lock_guard guard(state.lock);
     jitc_sync_thread();
+    jitc_llvm_check_cancelled("jit_sync_thread");
 }
 
 void jit_sync_device() {
     lock_guard guard(state.lock);
     jitc_sync_device();
+    jitc_llvm_check_cancelled("jit_sync_device");
 }
 
 void jit_sync_all_devices() {
     lock_guard guard(state.lock);
     jitc_sync_all_devices();
+    jitc_llvm_check_cancelled("jit_sync_all_devices");
+}
+
+void *jit_event_record(JitBackend backend, uint32_t index) {
+    lock_guard guard(state.lock);
+    return jitc_event_record(backend, index);
+}
+
+int jit_event_query(void *event) {
+    lock_guard guard(state.lock);
+    return jitc_event_query((Event *) event);
+}
+
+void jit_event_wait(void *event) {
+    lock_guard guard(state.lock);
+    jitc_event_wait((Event *) event);
+}
+
+void jit_event_destroy(void *event) {
+    lock_guard guard(state.lock);
+    jitc_event_destroy((Event *) event);
+}
+
+void jit_enqueue_host_func(JitBackend backend, void (*callback)(void *),
+                           void *payload, const uint32_t *deps,
+                           uint32_t dep_count) {
+    lock_guard guard(state.lock);
+    jitc_enqueue_host_func(backend, callback, payload, deps, dep_count);
 }
 
 void jit_flush_kernel_cache() {
@@ -325,6 +422,16 @@ void jit_flush_kernel_cache() {
     jitc_flush_kernel_cache();
 }
 
+uint32_t jit_kernel_pack_write(const char *path) {
+    lock_guard guard(state.lock);
+    return jitc_kernel_pack_write(path);
+}
+
+void jit_kernel_pack_load(const char *path) {
+    lock_guard guard(state.lock);
+    jitc_kernel_pack_load(path);
+}
+
 void *jit_malloc(AllocType type, size_t size) {
     lock_guard guard(state.lock);
     return jitc_malloc(type, size);
@@ -345,6 +452,11 @@ void jit_malloc_clear_statistics() {
     jitc_malloc_clear_statistics();
 }
 
+size_t jit_malloc_watermark(AllocType type) {
+    lock_guard guard(state.lock);
+    return jitc_malloc_watermark(type);
+}
+
 enum AllocType jit_malloc_type(void *ptr) {
     lock_guard guard(state.lock);
     return jitc_malloc_type(ptr);
@@ -475,6 +587,11 @@ int jit_var_is_evaluated(uint32_t index) {
     return (int) jitc_var(index)->is_data();
 }
 
+int jit_var_ready(uint32_t index) {
+    lock_guard guard(state.lock);
+    return jitc_var_ready(index);
+}
+
 int jit_var_is_placeholder(uint32_t index) {
     if (index == 0)
         return 0;
@@ -538,12 +655,64 @@ uint32_t jit_var_mem_map(JitBackend backend, VarType type, void *ptr, size_t siz
     return jitc_var_mem_map(backend, type, ptr, size, free);
 }
 
+uint32_t jit_var_mem_map_file(JitBackend backend, const char *path,
+                              size_t offset, VarType type, size_t count,
+                              MemAdvice advice) {
+    lock_guard guard(state.lock);
+    return jitc_var_mem_map_file(backend, path, offset, type, count, advice);
+}
+
+uint32_t jit_var_export_fd(uint32_t index, int *fd) {
+    lock_guard guard(state.lock);
+    return jitc_var_export_fd(index, fd);
+}
+
+uint32_t jit_var_import_fd(JitBackend backend, int fd, VarType type,
+                           size_t count) {
+    lock_guard guard(state.lock);
+    return jitc_var_import_fd(backend, fd, type, count);
+}
+
 uint32_t jit_var_mem_copy(JitBackend backend, AllocType atype, VarType vtype,
                           const void *value, size_t size) {
     lock_guard guard(state.lock);
     return jitc_var_mem_copy(backend, atype, vtype, value, size);
 }
 
+void jit_stream(JitBackend backend, size_t size, uint32_t chunk_size,
+                uint32_t input_count, const StreamInput *inputs,
+                void (*body)(void *payload, size_t start, uint32_t count,
+                             const uint32_t *in),
+                void *payload) {
+    lock_guard guard(state.lock);
+    jitc_stream(backend, size, chunk_size, input_count, inputs, body, payload);
+}
+
+void jit_var_save(uint32_t index, const char *path) {
+    lock_guard guard(state.lock);
+    jitc_var_save(index, path);
+}
+
+uint32_t jit_var_load(const char *path) {
+    lock_guard guard(state.lock);
+    return jitc_var_load(path);
+}
+
+void jit_aos_to_soa(JitBackend backend, const void *src, size_t stride,
+                    uint32_t count, uint32_t field_count, const VarType *types,
+                    const size_t *offsets, uint32_t *out) {
+    lock_guard guard(state.lock);
+    jitc_aos_to_soa(backend, src, stride, count, field_count, types, offsets,
+                    out);
+}
+
+uint32_t jit_soa_to_aos(JitBackend backend, void *dst, size_t stride,
+                        uint32_t field_count, const uint32_t *in,
+                        const size_t *offsets) {
+    lock_guard guard(state.lock);
+    return jitc_soa_to_aos(backend, dst, stride, field_count, in, offsets);
+}
+
 uint32_t jit_var_copy(uint32_t index) {
     lock_guard guard(state.lock);
     return jitc_var_copy(index);
@@ -624,6 +793,24 @@ uint32_t jit_var_write(uint32_t index, size_t offset, const void *src) {
     return jitc_var_write(index, offset, src);
 }
 
+void jit_var_read_many(uint32_t index, const size_t *offsets, uint32_t count,
+                       void *dst) {
+    lock_guard guard(state.lock);
+    jitc_var_read_many(index, offsets, count, dst);
+}
+
+void *jit_var_read_many_async(uint32_t index, const size_t *offsets,
+                              uint32_t count, void *dst) {
+    lock_guard guard(state.lock);
+    return jitc_var_read_many_async(index, offsets, count, dst);
+}
+
+uint32_t jit_var_write_many(uint32_t index, const size_t *offsets,
+                            uint32_t count, const void *src) {
+    lock_guard guard(state.lock);
+    return jitc_var_write_many(index, offsets, count, src);
+}
+
 void jit_var_printf(JitBackend backend, uint32_t mask, const char *fmt,
                     uint32_t narg, const uint32_t *arg) {
     lock_guard guard(state.lock);
@@ -634,6 +821,7 @@ void jit_eval() {
     lock_guard guard(state.lock);
     jitc_eval(thread_state_cuda);
     jitc_eval(thread_state_llvm);
+    jitc_llvm_check_cancelled("jit_eval");
 }
 
 int jit_var_eval(uint32_t index) {
@@ -687,6 +875,54 @@ void jit_scan_u32(JitBackend backend, const uint32_t *in, uint32_t size, uint32_
     jitc_scan_u32(backend, in, size, out);
 }
 
+void jit_shard_init(uint32_t rank, uint32_t size, ShardAllGather func,
+                    void *payload) {
+    lock_guard guard(state.lock);
+    jitc_shard_init(rank, size, func, payload);
+}
+
+void jit_shard_init_shm(const char *name, uint32_t rank, uint32_t size) {
+    lock_guard guard(state.lock);
+    jitc_shard_init_shm(name, rank, size);
+}
+
+void jit_shard_shutdown() {
+    lock_guard guard(state.lock);
+    jitc_shard_shutdown();
+}
+
+uint32_t jit_shard_rank() {
+    lock_guard guard(state.lock);
+    return jitc_shard_rank();
+}
+
+uint32_t jit_shard_size() {
+    lock_guard guard(state.lock);
+    return jitc_shard_size();
+}
+
+uint32_t jit_shard_slice(size_t size, size_t *offset) {
+    lock_guard guard(state.lock);
+    return jitc_shard_slice(size, offset);
+}
+
+void jit_reduce_all(JitBackend backend, VarType type, ReduceOp rtype,
+                    const void *ptr, uint32_t size, void *out) {
+    lock_guard guard(state.lock);
+    jitc_reduce_all(backend, type, rtype, ptr, size, out);
+}
+
+uint32_t jit_scan_u32_all(JitBackend backend, const uint32_t *in,
+                          uint32_t size, uint32_t *out) {
+    lock_guard guard(state.lock);
+    return jitc_scan_u32_all(backend, in, size, out);
+}
+
+uint32_t jit_var_reduce_all(uint32_t index, ReduceOp reduce_op) {
+    lock_guard guard(state.lock);
+    return jitc_var_reduce_all(index, reduce_op);
+}
+
 uint32_t jit_compress(JitBackend backend, const uint8_t *in, uint32_t size, uint32_t *out) {
     lock_guard guard(state.lock);
     return jitc_compress(backend, in, size, out);
@@ -710,6 +946,13 @@ void jit_block_sum(JitBackend backend, enum VarType type, const void *in, void *
     jitc_block_sum(backend, type, in, out, size, block_size);
 }
 
+void jit_spmv_csr(JitBackend backend, VarType type, const uint32_t *offsets,
+                  const uint32_t *cols, const void *values, const void *x,
+                  void *out, uint32_t rows, uint32_t nnz) {
+    lock_guard guard(state.lock);
+    jitc_spmv_csr(backend, type, offsets, cols, values, x, out, rows, nnz);
+}
+
 uint32_t jit_registry_put(JitBackend backend, const char *domain, void *ptr) {
     lock_guard guard(state.lock);
     return jitc_registry_put(backend, domain, ptr);
@@ -868,6 +1111,23 @@ void jit_llvm_ray_trace(uint32_t func, uint32_t scene, int shadow_ray,
     jitc_llvm_ray_trace(func, scene, shadow_ray, in, out);
 }
 
+void jit_llvm_register_module(const void *data, size_t size) {
+    lock_guard guard(state.lock);
+    jitc_llvm_register_module(data, size);
+}
+
+uint32_t jit_llvm_call(const char *name, VarType type, uint32_t n_args,
+                       const uint32_t *args) {
+    lock_guard guard(state.lock);
+    return jitc_llvm_call(name, type, n_args, args);
+}
+
+void jit_llvm_matvec(uint32_t weights, uint32_t bias, uint32_t rows,
+                     uint32_t cols, const uint32_t *in, uint32_t *out) {
+    lock_guard guard(state.lock);
+    jitc_llvm_matvec(weights, bias, rows, cols, in, out);
+}
+
 void *jit_cuda_tex_create(size_t ndim, const size_t *shape, size_t n_channels,
                           int filter_mode, int wrap_mode) {
     lock_guard guard(state.lock);
@@ -0,0 +1,205 @@
+/*
+    src/cow.cpp -- Copy-on-write duplication of large host memory regions
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "cow.h"
+#include "internal.h"
+#include "log.h"
+#include <mutex>
+#include <atomic>
+
+#if defined(__linux__)
+#  include <sys/mman.h>
+#  include <unistd.h>
+#  include <fcntl.h>
+
+/// In-memory file that backs one or more copy-on-write mappings
+struct CowFile {
+    int fd;
+    uint32_t ref_count;
+};
+
+/// A memory region that privately maps a \ref CowFile
+struct CowMapping {
+    CowFile *file;
+
+    /// Number of mapped bytes (a multiple of the page size)
+    size_t size;
+};
+
+/// Guards the data structures below, which are also accessed by tasks
+static std::mutex jitc_cow_mutex;
+
+/// Map from the start address of a region to its mapping record
+static tsl::robin_map<uintptr_t, CowMapping, UInt64Hasher> jitc_cow_mappings;
+
+/// Number of entries of 'jitc_cow_mappings' (checked without locking)
+static std::atomic<uint32_t> jitc_cow_count { 0 };
+
+static void jitc_cow_file_dec_ref(CowFile *file) {
+    if (--file->ref_count == 0) {
+        close(file->fd);
+        delete file;
+    }
+}
+
+/// Map 'file' over the region 'ptr' and record this in 'jitc_cow_mappings'
+static void jitc_cow_map(void *ptr, size_t size, CowFile *file) {
+    void *rv = mmap(ptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+                    file->fd, 0);
+    if (rv == MAP_FAILED)
+        jitc_fail("jit_cow_map(): mmap() failed!");
+
+    file->ref_count++;
+    auto [it, success] = jitc_cow_mappings.try_emplace(
+        (uintptr_t) ptr, CowMapping{ file, size });
+    if (success) {
+        jitc_cow_count++;
+    } else {
+        jitc_cow_file_dec_ref(it.value().file);
+        it.value() = CowMapping{ file, size };
+    }
+}
+
+/**
+ * Check if a copy-on-write mapping still matches the contents of its file.
+ *
+ * Writes to a private file mapping replace the affected pages with anonymous
+ * copies, which is visible in the page flags of \c /proc/self/pagemap. In
+ * contrast to tracking writes when they are traced, this also covers
+ * arbitrary in-place writers (kernels, memset, user code, etc.), and the
+ * result is consistent with the task order in which \ref jitc_cow_copy() runs.
+ */
+static bool jitc_cow_clean(const void *ptr, size_t size, size_t page_size) {
+    int fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    uint64_t entries[512];
+    size_t pages = size / page_size,
+           first = (uintptr_t) ptr / page_size;
+    bool clean = true;
+
+    for (size_t i = 0; i < pages && clean; i += 512) {
+        size_t count = std::min(pages - i, (size_t) 512),
+               bytes = count * sizeof(uint64_t);
+
+        if (pread(fd, entries, bytes, (off_t) ((first + i) * sizeof(uint64_t))) !=
+            (ssize_t) bytes) {
+            clean = false;
+            break;
+        }
+
+        for (size_t j = 0; j < count && clean; ++j) {
+            uint64_t e = entries[j];
+            bool present = (e >> 63) & 1, swapped = (e >> 62) & 1,
+                 file_page = (e >> 61) & 1;
+
+            // Present or swapped anonymous pages were written to
+            clean = !((present || swapped) && !file_page);
+        }
+    }
+
+    close(fd);
+    return clean;
+}
+
+bool jitc_cow_copy(void *dst, const void *src, size_t size) {
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE),
+           size_map  = size / page_size * page_size;
+
+    if (size < DRJIT_COW_THRESHOLD || (uintptr_t) dst % page_size != 0 ||
+        (uintptr_t) src % page_size != 0)
+        return false;
+
+    /* Scope */ {
+        std::lock_guard<std::mutex> guard(jitc_cow_mutex);
+
+        CowFile *file = nullptr;
+        auto it = jitc_cow_mappings.find((uintptr_t) src);
+        if (it != jitc_cow_mappings.end() && it->second.size >= size_map &&
+            jitc_cow_clean(src, size_map, page_size))
+            file = it->second.file;
+
+        if (!file) {
+            // Move the current contents of 'src' into a new file
+            int fd = memfd_create("drjit-cow", MFD_CLOEXEC);
+            if (fd < 0)
+                return false;
+
+            void *view = MAP_FAILED;
+            if (ftruncate(fd, (off_t) size_map) == 0)
+                view = mmap(nullptr, size_map, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, fd, 0);
+
+            if (view == MAP_FAILED) {
+                close(fd);
+                return false;
+            }
+
+            memcpy(view, src, size_map);
+            munmap(view, size_map);
+
+            file = new CowFile{ fd, 0 };
+            jitc_cow_map((void *) src, size_map, file);
+        }
+
+        jitc_cow_map(dst, size_map, file);
+    }
+
+    memcpy((uint8_t *) dst + size_map, (const uint8_t *) src + size_map,
+           size - size_map);
+
+    return true;
+}
+
+bool jitc_cow_mapped(const void *ptr) {
+    if (jitc_cow_count.load(std::memory_order_relaxed) == 0)
+        return false;
+
+    std::lock_guard<std::mutex> guard(jitc_cow_mutex);
+    return jitc_cow_mappings.find((uintptr_t) ptr) != jitc_cow_mappings.end();
+}
+
+void jitc_cow_release(void *ptr) {
+    std::lock_guard<std::mutex> guard(jitc_cow_mutex);
+    auto it = jitc_cow_mappings.find((uintptr_t) ptr);
+    if (it == jitc_cow_mappings.end())
+        return;
+
+    CowMapping m = it->second;
+    jitc_cow_mappings.erase(it);
+    jitc_cow_count--;
+
+    void *rv = mmap(ptr, m.size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    if (rv == MAP_FAILED)
+        jitc_fail("jit_cow_release(): mmap() failed!");
+    madvise(ptr, m.size, MADV_HUGEPAGE);
+
+    jitc_cow_file_dec_ref(m.file);
+}
+
+bool jitc_cow_forget(void *ptr) {
+    std::lock_guard<std::mutex> guard(jitc_cow_mutex);
+    auto it = jitc_cow_mappings.find((uintptr_t) ptr);
+    if (it == jitc_cow_mappings.end())
+        return false;
+
+    CowFile *file = it->second.file;
+    jitc_cow_mappings.erase(it);
+    jitc_cow_count--;
+    jitc_cow_file_dec_ref(file);
+    return true;
+}
+#else
+bool jitc_cow_copy(void *, const void *, size_t) { return false; }
+bool jitc_cow_mapped(const void *) { return false; }
+void jitc_cow_release(void *) { }
+bool jitc_cow_forget(void *) { return false; }
+#endif
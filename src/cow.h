@@ -0,0 +1,57 @@
+/*
+    src/cow.h -- Copy-on-write duplication of large host memory regions
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/// Minimum size (in bytes) of buffers that are duplicated via copy-on-write
+#define DRJIT_COW_THRESHOLD (16 * 1024 * 1024)
+
+/**
+ * \brief Try to turn 'dst' into a copy-on-write duplicate of 'src'
+ *
+ * Variables are immutable from the perspective of the user, hence a scatter
+ * into an array that is referenced elsewhere must first duplicate it. For
+ * large host-asynchronous allocations, this function avoids copying the data.
+ * Instead, the contents of 'src' are moved into an anonymous in-memory file
+ * (\c memfd), and both 'src' and 'dst' are replaced by private mappings of this
+ * file. The OS then only duplicates the pages that are subsequently written
+ * to. The file is reused as long as no page of 'src' was modified (this is
+ * checked when the copy takes place), which makes further duplicates almost
+ * free.
+ *
+ * Both regions must be page-aligned allocations created by \ref jitc_malloc().
+ * Any remainder not covering a full page is copied. The function must be
+ * called from a task that is ordered after all prior accesses to 'dst' and
+ * writes to 'src'. It returns \c false if the operation is unsupported
+ * (non-Linux platform, misaligned/small regions, or failure of a system call),
+ * in which case the caller should fall back to \c memcpy().
+ */
+extern bool jitc_cow_copy(void *dst, const void *src, size_t size);
+
+/// Is 'ptr' (currently) a copy-on-write mapping?
+extern bool jitc_cow_mapped(const void *ptr);
+
+/**
+ * \brief Replace a copy-on-write mapping by regular anonymous memory before it
+ * is returned to the allocation cache. Must be called once no more tasks
+ * access the region.
+ */
+extern void jitc_cow_release(void *ptr);
+
+/**
+ * \brief Stop tracking the copy-on-write mapping 'ptr' without changing its
+ * contents, e.g., when it is migrated to another allocation type
+ *
+ * The region remains a private mapping of the file, which the OS keeps alive
+ * until the region is unmapped. Returns \c false if 'ptr' wasn't tracked.
+ */
+extern bool jitc_cow_forget(void *ptr);
@@ -40,7 +40,24 @@ void *jitc_cuda_lookup(const char *name) {
 
 static void *jitc_cuda_handle = nullptr;
 
+/// Value of 'jitc_cuda_handle' when a virtual device is emulated
+static char jitc_cuda_virtual_handle[1];
+
 bool jitc_cuda_api_init() {
+    if (jitc_cuda_virtual_cc) {
+        if (jitc_cuda_handle == jitc_cuda_virtual_handle)
+            return true;
+
+        // Unload the driver library (it has no usable devices anyways)
+        jitc_cuda_api_shutdown();
+        jitc_cuda_virtual_api_init();
+        jitc_cuda_handle = jitc_cuda_virtual_handle;
+        return true;
+    }
+
+    if (jitc_cuda_handle == jitc_cuda_virtual_handle)
+        jitc_cuda_api_shutdown();
+
     if (jitc_cuda_handle)
         return true;
 
@@ -92,6 +109,7 @@ bool jitc_cuda_api_init() {
         LOAD(cuDriverGetVersion);
         LOAD(cuEventCreate);
         LOAD(cuEventDestroy, "v2");
+        LOAD(cuEventQuery);
         LOAD(cuEventRecord);
         LOAD(cuEventSynchronize);
         LOAD(cuEventElapsedTime);
@@ -165,7 +183,7 @@ void jitc_cuda_api_shutdown() {
     Z(cuDeviceGet); Z(cuDeviceGetAttribute); Z(cuDeviceGetCount);
     Z(cuDeviceGetName); Z(cuDevicePrimaryCtxRelease);
     Z(cuDevicePrimaryCtxRetain); Z(cuDeviceTotalMem); Z(cuDriverGetVersion);
-    Z(cuEventCreate); Z(cuEventDestroy); Z(cuEventRecord);
+    Z(cuEventCreate); Z(cuEventDestroy); Z(cuEventQuery); Z(cuEventRecord);
     Z(cuEventSynchronize); Z(cuEventElapsedTime); Z(cuFuncSetAttribute);
     Z(cuGetErrorName); Z(cuGetErrorString); Z(cuInit); Z(cuLaunchHostFunc);
     Z(cuLaunchKernel); Z(cuLinkAddData); Z(cuLinkComplete); Z(cuLinkCreate);
@@ -181,17 +199,21 @@ void jitc_cuda_api_shutdown() {
     Z(cuTexObjectDestroy); Z(cuMemcpy2DAsync); Z(cuMemcpy3DAsync);
     #undef Z
 
+    if (jitc_cuda_handle != jitc_cuda_virtual_handle) {
 #if !defined(_WIN32)
-    if (jitc_cuda_handle != RTLD_NEXT)
-        dlclose(jitc_cuda_handle);
+        if (jitc_cuda_handle != RTLD_NEXT)
+            dlclose(jitc_cuda_handle);
 #else
-    FreeLibrary((HMODULE) jitc_cuda_handle);
+        FreeLibrary((HMODULE) jitc_cuda_handle);
 #endif
+    }
 
     jitc_cuda_handle = nullptr;
 }
 
 void *jitc_cuda_lookup(const char *name) {
+    if (jitc_cuda_handle == jitc_cuda_virtual_handle)
+        jitc_raise("jit_cuda_lookup(): not supported by the virtual CUDA device!");
     void *ptr = dlsym(jitc_cuda_handle, name);
     if (!ptr)
         jitc_raise("jit_cuda_lookup(): function \"%s\" not found!", name);
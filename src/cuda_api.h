@@ -20,6 +20,16 @@ extern void jitc_cuda_api_shutdown();
 /// Look up a device driver function
 extern void *jitc_cuda_lookup(const char *name);
 
+/// Compute capability and PTX version of the virtual device (0: disabled)
+extern uint32_t jitc_cuda_virtual_cc, jitc_cuda_virtual_ptx;
+
+/// Emulate a CUDA device without a GPU, see \ref jit_cuda_set_virtual_device()
+extern void jitc_cuda_set_virtual_device(uint32_t ptx_version,
+                                         uint32_t compute_capability);
+
+/// Point the CUDA API functions to the host-side emulation of a virtual device
+extern void jitc_cuda_virtual_api_init();
+
 #if !defined(DRJIT_DYNAMIC_CUDA)
 #  include <cuda.h>
 #else
@@ -70,8 +80,10 @@ extern void *jitc_cuda_lookup(const char *name);
 #  define CUDA_ERROR_NOT_INITIALIZED 3
 #  define CUDA_ERROR_DEINITIALIZED 4
 #  define CUDA_ERROR_NOT_FOUND 500
+#  define CUDA_ERROR_NOT_READY 600
 #  define CUDA_ERROR_OUT_OF_MEMORY 2
 #  define CUDA_ERROR_PEER_ACCESS_ALREADY_ENABLED 704
+#  define CUDA_ERROR_NOT_SUPPORTED 801
 #  define CUDA_SUCCESS 0
 
 #define CU_RESOURCE_TYPE_ARRAY 0
@@ -217,6 +229,7 @@ DR_CUDA_SYM(CUresult (*cuDeviceTotalMem)(size_t *, CUdevice));
 DR_CUDA_SYM(CUresult (*cuDriverGetVersion)(int *));
 DR_CUDA_SYM(CUresult (*cuEventCreate)(CUevent *, unsigned int));
 DR_CUDA_SYM(CUresult (*cuEventDestroy)(CUevent));
+DR_CUDA_SYM(CUresult (*cuEventQuery)(CUevent));
 DR_CUDA_SYM(CUresult (*cuEventRecord)(CUevent, CUstream));
 DR_CUDA_SYM(CUresult (*cuEventSynchronize)(CUevent));
 DR_CUDA_SYM(CUresult (*cuEventElapsedTime)(float *, CUevent, CUevent));
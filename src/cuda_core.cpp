@@ -352,6 +352,13 @@ bool jitc_cuda_init() {
             }
         }
 
+        // Honor the exact target requested for a virtual device
+        if (jitc_cuda_virtual_cc) {
+            device.compute_capability = jitc_cuda_virtual_cc;
+            if (jitc_cuda_virtual_ptx)
+                device.ptx_version = jitc_cuda_virtual_ptx;
+        }
+
         state.devices.push_back(device);
     }
 
@@ -0,0 +1,290 @@
+/*
+    src/cuda_virtual.cpp -- Virtual CUDA device for generating PTX without a GPU
+
+    Copyright (c) 2022 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "cuda_api.h"
+#include "log.h"
+#include "internal.h"
+
+uint32_t jitc_cuda_virtual_cc = 0;
+uint32_t jitc_cuda_virtual_ptx = 0;
+
+#if defined(DRJIT_DYNAMIC_CUDA)
+
+void jitc_cuda_set_virtual_device(uint32_t ptx_version,
+                                  uint32_t compute_capability) {
+    if (compute_capability != 0 && compute_capability < 50)
+        jitc_raise("jit_cuda_set_virtual_device(): the compute capability "
+                   "must be at least 50!");
+    if (!state.devices.empty())
+        jitc_raise("jit_cuda_set_virtual_device(): the CUDA backend is already "
+                   "initialized, call jit_shutdown(0) first!");
+    jitc_cuda_virtual_cc = compute_capability;
+    jitc_cuda_virtual_ptx = compute_capability ? ptx_version : 0;
+}
+
+/* The functions below stand in for the CUDA driver API. They model a single
+   device whose "device memory" is ordinary host memory. Kernels are assembled
+   and "compiled" (the resulting image is the PTX code itself, which the driver
+   of a real device can later compile when loading it from the kernel cache),
+   but they are never executed. The contents of arrays computed by kernels are
+   therefore undefined (zero-initialized). */
+
+/// Placeholder target for handles (contexts, streams, modules, ..)
+static char virtual_handle_target[1];
+
+template <typename T> static T virtual_handle() {
+    return (T) (void *) virtual_handle_target;
+}
+
+struct VirtualLinkState {
+    char *ptx = nullptr;
+    size_t size = 0;
+};
+
+template <typename... Args> static CUresult virtual_success(Args...) {
+    return CUDA_SUCCESS;
+}
+
+template <typename... Args> static CUresult virtual_unsupported(Args...) {
+    return CUDA_ERROR_NOT_SUPPORTED;
+}
+
+static CUresult virtual_cuDeviceGetCount(int *count) {
+    *count = 1;
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuDeviceGet(CUdevice *dev, int ordinal) {
+    *dev = ordinal;
+    return ordinal == 0 ? CUDA_SUCCESS : CUDA_ERROR_INVALID_VALUE;
+}
+
+static CUresult virtual_cuDriverGetVersion(int *version) {
+    *version = 12000;
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuDeviceGetName(char *name, int len, CUdevice) {
+    snprintf(name, (size_t) len, "Virtual device (sm_%u)", jitc_cuda_virtual_cc);
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuDeviceGetAttribute(int *value, int attrib, CUdevice) {
+    switch (attrib) {
+        case CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MAJOR:
+            *value = (int) jitc_cuda_virtual_cc / 10; break;
+        case CU_DEVICE_ATTRIBUTE_COMPUTE_CAPABILITY_MINOR:
+            *value = (int) jitc_cuda_virtual_cc % 10; break;
+        case CU_DEVICE_ATTRIBUTE_MULTIPROCESSOR_COUNT: *value = 80; break;
+        case CU_DEVICE_ATTRIBUTE_UNIFIED_ADDRESSING: *value = 1; break;
+        case CU_DEVICE_ATTRIBUTE_MAX_SHARED_MEMORY_PER_BLOCK_OPTIN:
+            *value = 48 * 1024; break;
+        case CU_DEVICE_ATTRIBUTE_COMPUTE_PREEMPTION_SUPPORTED: *value = 1; break;
+        default: *value = 0; break;
+    }
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuDeviceTotalMem(size_t *bytes, CUdevice) {
+    *bytes = (size_t) 16 * 1024 * 1024 * 1024;
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuDeviceCanAccessPeer(int *can_access, CUdevice, CUdevice) {
+    *can_access = 0;
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuDevicePrimaryCtxRetain(CUcontext *ctx, CUdevice) {
+    *ctx = virtual_handle<CUcontext>();
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuCtxPopCurrent(CUcontext *ctx) {
+    if (ctx)
+        *ctx = virtual_handle<CUcontext>();
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuStreamCreate(CUstream *stream, unsigned int) {
+    *stream = virtual_handle<CUstream>();
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuEventCreate(CUevent *event, unsigned int) {
+    *event = virtual_handle<CUevent>();
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuEventElapsedTime(float *ms, CUevent, CUevent) {
+    *ms = 0.f;
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuGetErrorString(CUresult, const char **str) {
+    *str = "unsupported operation on a virtual CUDA device";
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuLaunchHostFunc(CUstream, void (*func)(void *),
+                                         void *payload) {
+    // Streams of the virtual device have no pending work
+    func(payload);
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuLaunchKernel(CUfunction, unsigned int, unsigned int,
+                                       unsigned int, unsigned int, unsigned int,
+                                       unsigned int, unsigned int, CUstream,
+                                       void **, void **) {
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuLinkCreate(unsigned int, int *, void **,
+                                     CUlinkState *state_out) {
+    *state_out = (CUlinkState) new VirtualLinkState();
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuLinkAddData(CUlinkState state_, int, void *data,
+                                      size_t size, const char *, unsigned int,
+                                      int *, void **) {
+    VirtualLinkState *s = (VirtualLinkState *) state_;
+    if (s->ptx)
+        return CUDA_ERROR_INVALID_VALUE;
+
+    // The image is the NUL-terminated PTX code
+    s->ptx = (char *) malloc_check(size + 1);
+    memcpy(s->ptx, data, size);
+    s->ptx[size] = '\0';
+    s->size = size + 1;
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuLinkComplete(CUlinkState state_, void **image,
+                                       size_t *size) {
+    VirtualLinkState *s = (VirtualLinkState *) state_;
+    *image = s->ptx;
+    *size = s->size;
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuLinkDestroy(CUlinkState state_) {
+    VirtualLinkState *s = (VirtualLinkState *) state_;
+    free(s->ptx);
+    delete s;
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuMemAlloc(void **ptr, size_t size) {
+    *ptr = calloc(1, size ? size : 1);
+    return *ptr ? CUDA_SUCCESS : CUDA_ERROR_OUT_OF_MEMORY;
+}
+
+static CUresult virtual_cuMemFree(void *ptr) {
+    free(ptr);
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuMemcpy(void *dst, const void *src, size_t size) {
+    memcpy(dst, src, size);
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuMemcpyAsync(void *dst, const void *src, size_t size,
+                                      CUstream) {
+    memcpy(dst, src, size);
+    return CUDA_SUCCESS;
+}
+
+template <typename T>
+static CUresult virtual_cuMemsetAsync(void *ptr, T value, size_t count,
+                                      CUstream) {
+    for (size_t i = 0; i < count; ++i)
+        ((T *) ptr)[i] = value;
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuModuleLoadData(CUmodule *mod, const void *) {
+    *mod = virtual_handle<CUmodule>();
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuModuleGetFunction(CUfunction *func, CUmodule,
+                                            const char *) {
+    *func = virtual_handle<CUfunction>();
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuOccupancyMaxPotentialBlockSize(int *grid_size,
+                                                         int *block_size,
+                                                         CUfunction, void *,
+                                                         size_t, int) {
+    *grid_size = 80 * 8;
+    *block_size = 128;
+    return CUDA_SUCCESS;
+}
+
+static CUresult virtual_cuPointerGetAttribute(void *data, int, void *) {
+    *(int *) data = CU_MEMORYTYPE_DEVICE;
+    return CUDA_SUCCESS;
+}
+
+void jitc_cuda_virtual_api_init() {
+    #define V(name) name = virtual_##name
+    #define S(name) name = virtual_success
+    #define U(name) name = virtual_unsupported
+
+    S(cuInit); V(cuDeviceGetCount); V(cuDeviceGet); V(cuDriverGetVersion);
+    V(cuDeviceGetName); V(cuDeviceGetAttribute); V(cuDeviceTotalMem);
+    V(cuDeviceCanAccessPeer); V(cuDevicePrimaryCtxRetain);
+    V(cuCtxPopCurrent); V(cuStreamCreate); V(cuEventCreate);
+    V(cuEventElapsedTime); V(cuLaunchHostFunc); V(cuLaunchKernel);
+    V(cuLinkCreate); V(cuLinkAddData); V(cuLinkComplete); V(cuLinkDestroy);
+    V(cuMemAlloc); V(cuMemFree); V(cuMemcpy); V(cuMemcpyAsync);
+    V(cuModuleLoadData); V(cuModuleGetFunction);
+    V(cuOccupancyMaxPotentialBlockSize); V(cuPointerGetAttribute);
+
+    cuMemAllocHost = virtual_cuMemAlloc;
+    cuMemFreeHost = virtual_cuMemFree;
+    cuMemsetD8Async = virtual_cuMemsetAsync<unsigned char>;
+    cuMemsetD16Async = virtual_cuMemsetAsync<unsigned short>;
+    cuMemsetD32Async = virtual_cuMemsetAsync<unsigned int>;
+    cuGetErrorName = virtual_cuGetErrorString;
+    cuGetErrorString = virtual_cuGetErrorString;
+
+    S(cuCtxEnablePeerAccess); S(cuCtxSynchronize);
+    S(cuDevicePrimaryCtxRelease); S(cuEventDestroy); S(cuEventQuery);
+    S(cuEventRecord); S(cuEventSynchronize); S(cuFuncSetAttribute);
+    S(cuMemAdvise); S(cuModuleUnload); S(cuCtxPushCurrent);
+    S(cuStreamDestroy); S(cuStreamSynchronize); S(cuStreamWaitEvent);
+
+    // Textures are not supported by the virtual device
+    U(cuArrayCreate); U(cuArray3DCreate); U(cuArray3DGetDescriptor);
+    U(cuArrayDestroy); U(cuTexObjectCreate); U(cuTexObjectGetResourceDesc);
+    U(cuTexObjectDestroy); U(cuMemcpy2DAsync); U(cuMemcpy3DAsync);
+
+    cuMemAllocAsync = nullptr;
+    cuMemFreeAsync = nullptr;
+
+    #undef V
+    #undef S
+    #undef U
+
+    jitc_log(Info, "jit_cuda_api_init(): using a virtual CUDA device "
+             "(compute capability %u, PTX version %u). Kernels are generated "
+             "but not executed!", jitc_cuda_virtual_cc,
+             jitc_cuda_virtual_ptx);
+}
+#else
+void jitc_cuda_set_virtual_device(uint32_t, uint32_t) {
+    jitc_raise("jit_cuda_set_virtual_device(): this feature requires a build "
+               "with the DRJIT_DYNAMIC_CUDA option!");
+}
+#endif
@@ -15,6 +15,9 @@
 #include "util.h"
 #include "optix.h"
 #include "loop.h"
+#include "numa.h"
+#include "llvm_pool.h"
+#include "event.h"
 #include <tsl/robin_set.h>
 
 // ====================================================================
@@ -46,6 +49,12 @@ StringBuffer globals { 1000 };
 /// Temporary scratch space for scheduled tasks (LLVM only)
 static std::vector<Task *> scheduled_tasks;
 
+/// Maps kernel outputs to inputs whose memory they reuse, and auxiliary map
+static tsl::robin_map<uint32_t, uint32_t, UInt32Hasher> donations, consumers;
+
+/// Lane-to-lane strides of affine index computations (see jitc_assemble_affine())
+tsl::robin_map<uint32_t, int32_t, UInt32Hasher> affine_strides;
+
 /// Hash code of the last generated kernel
 XXH128_hash_t kernel_hash { 0, 0 };
 
@@ -58,6 +67,9 @@ static uint32_t n_ops_total = 0;
 /// Are we recording an OptiX kernel?
 bool uses_optix = false;
 
+/// Does the kernel store outputs in the memory of inputs?
+bool uses_donations = false;
+
 /// Size and alignment of auxiliary buffer needed by virtual function calls
 int32_t alloca_size = -1;
 int32_t alloca_align = -1;
@@ -76,6 +88,100 @@ KernelHistoryEntry kernel_history_entry;
 
 // ====================================================================
 
+/// Can the memory of the evaluated variable 'v' be donated to an output?
+static bool jitc_var_donatable(const Variable *v, uint32_t size) {
+    return v->is_data() && v->size == size && v->ref_count == 1 &&
+           !v->is_dirty() && !v->retain_data && !v->extra && !v->placeholder;
+}
+
+/**
+ * \brief Find kernel outputs that can be stored in the memory of an input
+ *
+ * This is the case when the input is only referenced by a chain of
+ * elementwise operations (each with a single reference) that ends in the
+ * output, as in <tt>x = x * 2 + 1</tt>. Every lane then reads its input entry
+ * before writing the output entry at the same position, and the input
+ * variable is released once the outputs have been computed.
+ */
+static void jitc_assemble_donate(ThreadState *ts, const ScheduledGroup &group) {
+    donations.clear();
+
+    bool found = false;
+    for (uint32_t i = group.start; i != group.end && !found; ++i)
+        found = jitc_var_donatable(jitc_var(schedule[i].index), group.size);
+    if (!found)
+        return;
+
+    consumers.clear();
+    for (uint32_t i = group.start; i != group.end; ++i) {
+        uint32_t index = schedule[i].index;
+        const Variable *v = jitc_var(index);
+        for (int j = 0; j < 4; ++j) {
+            if (v->dep[j])
+                consumers[v->dep[j]] = index;
+        }
+    }
+
+    JitBackend backend = ts->backend;
+    AllocType atype = backend == JitBackend::CUDA ? AllocType::Device
+                                                  : AllocType::HostAsync;
+
+    for (uint32_t i = group.start; i != group.end; ++i) {
+        uint32_t index = schedule[i].index;
+        const Variable *v = jitc_var(index);
+        if (!jitc_var_donatable(v, group.size))
+            continue;
+
+        auto it = state.alloc_used.find((uintptr_t) v->data);
+        if (it == state.alloc_used.end())
+            continue;
+        auto [alloc_size, alloc_type, alloc_device] =
+            alloc_info_decode(it->second);
+        if (alloc_type != atype ||
+            (backend == JitBackend::CUDA && alloc_device != ts->device))
+            continue;
+
+        uint32_t cur = index;
+        while (true) {
+            auto it2 = consumers.find(cur);
+            if (it2 == consumers.end())
+                break;
+
+            uint32_t next = it2->second;
+            const Variable *v2 = jitc_var(next);
+            VarKind kind = (VarKind) v2->kind;
+
+            /* Gathers are fine, since the input can only be the index or the
+               mask (reading from the input would require a pointer variable,
+               which holds another reference) */
+            bool elementwise =
+                (kind >= VarKind::Nop && kind <= VarKind::Bitcast) ||
+                kind == VarKind::Gather;
+
+            if (!elementwise || v2->extra || v2->side_effect ||
+                v2->size != group.size)
+                break;
+
+            if (v2->output_flag) {
+                /* Element 'i' of the output must occupy the same bytes as
+                   element 'i' of the input. Otherwise, a block could
+                   overwrite inputs that another block is still reading. */
+                size_t isize = (size_t) type_size[v2->type],
+                       dsize = (size_t) group.size * isize;
+                if (backend == JitBackend::LLVM && isize < 4)
+                    dsize += 4 - isize;
+                if (isize == (size_t) type_size[v->type] && dsize <= alloc_size)
+                    donations.emplace(next, index);
+                break;
+            }
+
+            if (v2->ref_count != 1)
+                break;
+            cur = next;
+        }
+    }
+}
+
 /// Recursively traverse the computation graph to find variables needed by a computation
 static void jitc_var_traverse(uint32_t size, uint32_t index) {
     if (!visited.emplace(size, index).second)
@@ -110,6 +216,311 @@ static void jitc_var_traverse(uint32_t size, uint32_t index) {
     schedule.emplace_back(size, v->scope, index);
 }
 
+/**
+ * Estimate the memory traffic and arithmetic work of a kernel for the roofline
+ * metrics of its kernel history entry. Input/output parameters contribute
+ * their full size, gathers and scatters one element per lane, and arithmetic
+ * operations one operation per lane (FMAs count as two).
+ */
+static void jitc_assemble_roofline(ScheduledGroup group,
+                                   KernelHistoryEntry &e) {
+    uint64_t size = group.size, bytes_read = 0, bytes_written = 0, ops = 0;
+
+    for (uint32_t group_index = group.start; group_index != group.end; ++group_index) {
+        const Variable *v = jitc_var(schedule[group_index].index);
+        uint64_t isize = type_size[v->type];
+
+        if (v->param_type == ParamType::Input) {
+            // Pointer literals are accounted for by the gathers/scatters
+            if (v->is_data())
+                bytes_read += (uint64_t) v->size * isize;
+            continue;
+        } else if (v->param_type == ParamType::Output) {
+            bytes_written += size * isize;
+        }
+
+        switch ((VarKind) v->kind) {
+            case VarKind::Gather:
+                bytes_read += size * isize;
+                break;
+
+            case VarKind::Scatter: {
+                    uint64_t vsize = size * type_size[jitc_var(v->dep[1])->type];
+                    bytes_written += vsize;
+                    // Reductions read the previous value
+                    if ((ReduceOp) v->literal != ReduceOp::None) {
+                        bytes_read += vsize;
+                        ops += size;
+                    }
+                }
+                break;
+
+            case VarKind::ScatterKahan: {
+                    const Extra &extra = state.extra[schedule[group_index].index];
+                    uint64_t vsize = size * type_size[jitc_var(extra.dep[4])->type];
+                    bytes_read += 2 * vsize;
+                    bytes_written += 2 * vsize;
+                    ops += 4 * size;
+                }
+                break;
+
+            case VarKind::Fma:
+                ops += 2 * size;
+                break;
+
+            case VarKind::MatVec: {
+                    // The (shared) weights are mostly served from the cache
+                    uint64_t rows = (uint32_t) v->literal,
+                             cols = v->literal >> 32;
+                    ops += 2 * rows * cols * size;
+                }
+                break;
+
+            default:
+                // Casts only move data and don't count as arithmetic
+                if (v->kind >= (uint32_t) VarKind::Neg &&
+                    v->kind < (uint32_t) VarKind::Cast)
+                    ops += size;
+                break;
+        }
+    }
+
+    e.bytes_read = bytes_read;
+    e.bytes_written = bytes_written;
+    e.arithmetic_ops = ops;
+    if (bytes_read + bytes_written)
+        e.arithmetic_intensity = (float) ((double) ops / (double) (bytes_read + bytes_written));
+}
+
+bool jitc_uniform_mask(uint32_t mask, uint32_t *out) {
+    const Variable *v = jitc_var(mask);
+    *out = 0;
+
+    if (v->kind == (uint32_t) VarKind::DefaultMask)
+        return true;
+
+    if (v->uniform) {
+        *out = mask;
+        return true;
+    }
+
+    if (v->kind == (uint32_t) VarKind::And) {
+        for (int i = 0; i < 2; ++i) {
+            const Variable *a0 = jitc_var(v->dep[i]),
+                           *a1 = jitc_var(v->dep[1 - i]);
+            if (a0->kind == (uint32_t) VarKind::DefaultMask && a1->uniform) {
+                *out = v->dep[1 - i];
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/// Can an operation of this kind be evaluated once for all lanes?
+static bool jitc_uniform_kind(VarKind kind) {
+    switch (kind) {
+        case VarKind::Neg:     case VarKind::Sqrt:  case VarKind::Abs:
+        case VarKind::Add:     case VarKind::Sub:   case VarKind::Mul:
+        case VarKind::Div:     case VarKind::Mod:   case VarKind::Mulhi:
+        case VarKind::Fma:     case VarKind::Min:   case VarKind::Max:
+        case VarKind::Ceil:    case VarKind::Floor: case VarKind::Round:
+        case VarKind::Trunc:   case VarKind::Eq:    case VarKind::Neq:
+        case VarKind::Lt:      case VarKind::Le:    case VarKind::Gt:
+        case VarKind::Ge:      case VarKind::Select: case VarKind::Popc:
+        case VarKind::Clz:     case VarKind::Ctz:   case VarKind::And:
+        case VarKind::Or:      case VarKind::Xor:   case VarKind::Shl:
+        case VarKind::Shr:     case VarKind::Cast:  case VarKind::Bitcast:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+/**
+ * Mark the variables of an LLVM kernel whose value is the same in all lanes:
+ * scalar inputs and literals, arithmetic involving only such values, and
+ * gathers from a uniform index. \ref jitc_llvm_assemble() computes them once
+ * at the beginning of the kernel instead of once per packet. Kernel outputs
+ * are excluded, as their address depends on the lane.
+ */
+static void jitc_assemble_uniform(ScheduledGroup group) {
+    for (uint32_t group_index = group.start; group_index != group.end; ++group_index) {
+        Variable *v = jitc_var(schedule[group_index].index);
+        VarType vt = (VarType) v->type;
+        v->uniform = false;
+
+        if (v->extra || v->side_effect || vt == VarType::Void ||
+            vt == VarType::Float16 || v->param_type == ParamType::Output)
+            continue;
+
+        if (v->param_type == ParamType::Input) {
+            v->uniform = v->size == 1;
+            continue;
+        } else if (v->is_literal()) {
+            v->uniform = vt != VarType::Pointer;
+            continue;
+        } else if (vt == VarType::Pointer) {
+            continue;
+        }
+
+        bool uniform;
+        if (v->kind == (uint32_t) VarKind::Gather) {
+            uint32_t mask;
+            uniform = jitc_var(v->dep[0])->uniform &&
+                      jitc_var(v->dep[1])->uniform &&
+                      jitc_uniform_mask(v->dep[2], &mask);
+        } else {
+            uniform = jitc_uniform_kind((VarKind) v->kind);
+            for (int i = 0; i < 4 && uniform; ++i) {
+                if (!v->dep[i])
+                    break;
+                const Variable *v2 = jitc_var(v->dep[i]);
+                uniform = v2->uniform && v2->type != (uint32_t) VarType::Pointer &&
+                          v2->type != (uint32_t) VarType::Float16;
+            }
+        }
+
+        v->uniform = uniform;
+    }
+}
+
+/// Return the lane-to-lane stride of an integer variable, if it is affine
+static bool jitc_affine_stride(uint32_t index, int64_t *stride) {
+    const Variable *v = jitc_var(index);
+    if (v->uniform) {
+        *stride = 0;
+        return true;
+    }
+
+    auto it = affine_strides.find(index);
+    if (it == affine_strides.end())
+        return false;
+
+    *stride = it->second;
+    return true;
+}
+
+/// Return the value of an integer literal, interpreted as a signed number
+static bool jitc_affine_literal(uint32_t index, int64_t *value) {
+    const Variable *v = jitc_var(index);
+    if (!v->is_literal())
+        return false;
+
+    switch ((VarType) v->type) {
+        case VarType::Int32:
+        case VarType::UInt32: *value = (int32_t) (uint32_t) v->literal; break;
+        case VarType::Int64:
+        case VarType::UInt64: *value = (int64_t) v->literal; break;
+        default: return false;
+    }
+
+    // Larger factors are of no use and could overflow
+    return *value > -(1 << 20) && *value < (1 << 20);
+}
+
+/**
+ * Determine integer variables of an LLVM kernel that are affine functions of
+ * the lane index, like <tt>i</tt>, <tt>2*i+1</tt>, or <tt>i + offset</tt>,
+ * where \c i is a \c VarKind::Counter and \c offset is uniform (see
+ * jitc_assemble_uniform()). \ref jitc_llvm_assemble() turns gathers and
+ * scatters with such an index into contiguous or strided packet accesses
+ * instead of <tt>llvm.masked.gather/scatter</tt>.
+ */
+static void jitc_assemble_affine(ScheduledGroup group) {
+    affine_strides.clear();
+
+    for (uint32_t group_index = group.start; group_index != group.end; ++group_index) {
+        uint32_t index = schedule[group_index].index;
+        const Variable *v = jitc_var(index);
+        VarType vt = (VarType) v->type;
+
+        if (v->uniform || v->extra ||
+            (vt != VarType::Int32 && vt != VarType::UInt32 &&
+             vt != VarType::Int64 && vt != VarType::UInt64))
+            continue;
+
+        int64_t s0, s1, value, stride;
+        switch ((VarKind) v->kind) {
+            case VarKind::Counter:
+                stride = 1;
+                break;
+
+            case VarKind::Add:
+            case VarKind::Sub:
+                if (!jitc_affine_stride(v->dep[0], &s0) ||
+                    !jitc_affine_stride(v->dep[1], &s1))
+                    continue;
+                stride = v->kind == (uint32_t) VarKind::Add ? s0 + s1 : s0 - s1;
+                break;
+
+            case VarKind::Neg:
+                if (!jitc_affine_stride(v->dep[0], &s0))
+                    continue;
+                stride = -s0;
+                break;
+
+            case VarKind::Mul:
+                if (jitc_affine_literal(v->dep[1], &value) &&
+                    jitc_affine_stride(v->dep[0], &s0))
+                    stride = s0 * value;
+                else if (jitc_affine_literal(v->dep[0], &value) &&
+                         jitc_affine_stride(v->dep[1], &s1))
+                    stride = s1 * value;
+                else
+                    continue;
+                break;
+
+            case VarKind::Fma:
+                if (!jitc_affine_stride(v->dep[2], &stride))
+                    continue;
+                if (jitc_affine_literal(v->dep[1], &value) &&
+                    jitc_affine_stride(v->dep[0], &s0))
+                    stride += s0 * value;
+                else if (jitc_affine_literal(v->dep[0], &value) &&
+                         jitc_affine_stride(v->dep[1], &s1))
+                    stride += s1 * value;
+                else
+                    continue;
+                break;
+
+            case VarKind::Shl:
+                if (!jitc_affine_literal(v->dep[1], &value) ||
+                    value < 0 || value > 16 ||
+                    !jitc_affine_stride(v->dep[0], &s0))
+                    continue;
+                stride = s0 * ((int64_t) 1 << value);
+                break;
+
+            case VarKind::Cast: {
+                    /* Same-width and sign-extending integer conversions. Zero
+                       extension doesn't preserve the stride: the narrow lane
+                       values may wrap around (e.g. 'c - i' with unsigned 'i'),
+                       which turns a small difference into a large one. */
+                    const Variable *v2 = jitc_var(v->dep[0]);
+                    uint32_t size_in = type_size[v2->type],
+                             size_out = type_size[v->type];
+                    if (v2->type == (uint32_t) VarType::Bool ||
+                        v2->type == (uint32_t) VarType::Pointer ||
+                        jitc_is_float(v2) || size_in > size_out ||
+                        (size_in < size_out && !jitc_is_sint(v2)) ||
+                        !jitc_affine_stride(v->dep[0], &s0))
+                        continue;
+                    stride = s0;
+                }
+                break;
+
+            default:
+                continue;
+        }
+
+        if (stride > -(1 << 20) && stride < (1 << 20))
+            affine_strides[index] = (int32_t) stride;
+    }
+}
+
 void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
     JitBackend backend = ts->backend;
 
@@ -139,14 +550,20 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
         // The first 3 variables are reserved on the CUDA backend
         n_regs = 4;
     } else {
-        // First 3 parameters reserved for: kernel ptr, size, ITT identifier
-        for (int i = 0; i < 3; ++i)
+        /* First 5 parameters reserved for: kernel ptr, size, ITT identifier,
+           cancellation token, and launch ID */
+        for (int i = 0; i < 5; ++i)
             kernel_params.push_back(nullptr);
         n_regs = 1;
     }
 
     (void) timer();
 
+    donations.clear();
+    if (jitc_flags() & (uint32_t) JitFlag::DonateBuffers)
+        jitc_assemble_donate(ts, group);
+    uses_donations = !donations.empty();
+
     for (uint32_t group_index = group.start; group_index != group.end; ++group_index) {
         ScheduledVariable &sv = schedule[group_index];
         uint32_t index = sv.index;
@@ -181,10 +598,20 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
             if (backend == JitBackend::LLVM && isize < 4)
                 dsize += 4 - isize;
 
-            sv.data = jitc_malloc(
-                backend == JitBackend::CUDA ? AllocType::Device
-                                            : AllocType::HostAsync,
-                dsize); // Note: unsafe to access 'v' after jitc_malloc().
+            auto it = donations.find(index);
+            if (it != donations.end()) {
+                // Reuse the memory of an input (see jitc_assemble_donate())
+                Variable *v2 = jitc_var(it->second);
+                sv.data = v2->data;
+                v2->retain_data = true;
+                jitc_log(Debug, "jit_assemble(): r%u reuses the memory of r%u.",
+                         index, it->second);
+            } else {
+                sv.data = jitc_malloc(
+                    backend == JitBackend::CUDA ? AllocType::Device
+                                                : AllocType::HostAsync,
+                    dsize); // Note: unsafe to access 'v' after jitc_malloc().
+            }
 
             kernel_params.push_back(sv.data);
         } else if (v->is_literal() && (VarType) v->type == VarType::Pointer) {
@@ -232,6 +659,11 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
         kernel_params.push_back(kernel_params_global);
     }
 
+    if (backend == JitBackend::LLVM) {
+        jitc_assemble_uniform(group);
+        jitc_assemble_affine(group);
+    }
+
     bool trace = std::max(state.log_level_stderr, state.log_level_callback) >=
                  LogLevel::Trace;
 
@@ -255,6 +687,8 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
                 buffer.put("literal, ");
             if (v->size == 1 && v->param_type != ParamType::Output)
                 buffer.put("scalar, ");
+            if (v->uniform)
+                buffer.put("uniform, ");
             if (v->side_effect)
                 buffer.put("side effects, ");
             buffer.rewind_to(buffer.size() - 2);
@@ -318,12 +752,45 @@ void jitc_assemble(ThreadState *ts, ScheduledGroup group) {
         kernel_history_entry.output_count = n_params_out + n_side_effects;
         kernel_history_entry.operation_count = n_ops_total;
         kernel_history_entry.codegen_time = codegen_time * 1e-3f;
+        jitc_assemble_roofline(group, kernel_history_entry);
     }
 }
 
 static ProfilerRegion profiler_region_backend_compile("jit_eval: compiling");
 static ProfilerRegion profiler_region_backend_load("jit_eval: loading");
 
+/// Task callback that runs a block of work units of an LLVM kernel
+static void jitc_llvm_kernel_callback(uint32_t index, void *ptr) {
+    void **params = (void **) ptr;
+
+    // Stop processing work units once the launch has been cancelled
+    if (unlikely(jitc_llvm_cancelled((CancelToken *) params[3],
+                                     (uint64_t) (uintptr_t) params[4])))
+        return;
+
+    LLVMKernelFunction kernel = (LLVMKernelFunction) params[0];
+    uint32_t size       = (uint32_t) (uintptr_t) params[1],
+             block_size = (uint32_t) ((uintptr_t) params[1] >> 32),
+             start      = index * block_size,
+             end        = std::min(start + block_size, size);
+    uint64_t t0         = jitc_llvm_pool_time();
+
+#if defined(DRJIT_ENABLE_ITTNOTIFY)
+    // Signal start of kernel
+    __itt_task_begin(drjit_domain, __itt_null, __itt_null,
+                     (__itt_string_handle *) params[2]);
+#endif
+    // Perform the main computation
+    kernel(start, end, params);
+
+#if defined(DRJIT_ENABLE_ITTNOTIFY)
+    // Signal termination of kernel
+    __itt_task_end(drjit_domain);
+#endif
+
+    jitc_llvm_pool_account(t0);
+}
+
 Task *jitc_run(ThreadState *ts, ScheduledGroup group) {
     uint64_t flags = 0;
 
@@ -492,28 +959,6 @@ Task *jitc_run(ThreadState *ts, ScheduledGroup group) {
         uint32_t packets =
             (group.size + jitc_llvm_vector_width - 1) / jitc_llvm_vector_width;
 
-        auto callback = [](uint32_t index, void *ptr) {
-            void **params = (void **) ptr;
-            LLVMKernelFunction kernel = (LLVMKernelFunction) params[0];
-            uint32_t size       = (uint32_t) (uintptr_t) params[1],
-                     block_size = (uint32_t) ((uintptr_t) params[1] >> 32),
-                     start      = index * block_size,
-                     end        = std::min(start + block_size, size);
-
-#if defined(DRJIT_ENABLE_ITTNOTIFY)
-            // Signal start of kernel
-            __itt_task_begin(drjit_domain, __itt_null, __itt_null,
-                             (__itt_string_handle *) params[2]);
-#endif
-            // Perform the main computation
-            kernel(start, end, params);
-
-#if defined(DRJIT_ENABLE_ITTNOTIFY)
-            // Signal termination of kernel
-            __itt_task_end(drjit_domain);
-#endif
-        };
-
         uint32_t block_size = DRJIT_POOL_BLOCK_SIZE,
                  blocks = (group.size + block_size - 1) / block_size;
 
@@ -524,18 +969,44 @@ Task *jitc_run(ThreadState *ts, ScheduledGroup group) {
 #if defined(DRJIT_ENABLE_ITTNOTIFY)
         kernel_params[2] = kernel.llvm.itt;
 #endif
+        kernel_params[3] = &ts->cancel;
+        kernel_params[4] = (void *) (uintptr_t) ++ts->cancel.launch_id;
+
+        jitc_llvm_pool_launch(ts);
 
         jitc_trace("jit_run(): scheduling %u packet%s in %u block%s ..",
                    packets, packets == 1 ? "" : "s", blocks,
                    blocks == 1 ? "" : "s");
         (void) packets; // jitc_trace may be disabled
 
-        ret_task = task_submit_dep(
-            nullptr, &jitc_task, 1, blocks,
-            callback, kernel_params.data(),
-            (uint32_t) (kernel_params.size() * sizeof(void *)),
-            nullptr
-        );
+        /* Launches are ordered after all earlier work of the queue. Memory
+           released by that work is reused without further synchronization,
+           and side effects must take place in order. */
+        if (unlikely(jit_flag(JitFlag::NumaAffinity)) && blocks > 1 &&
+            jitc_numa_node_count() > 1) {
+            /* Hand out contiguous ranges of work units to the NUMA nodes
+               that first-touched the associated memory (see numa.h) */
+            size_t params_size = kernel_params.size() * sizeof(void *);
+            NumaSchedule *sched = jitc_numa_schedule_new(blocks, params_size);
+            memcpy(sched->payload(), kernel_params.data(), params_size);
+
+            ret_task = task_submit_dep(
+                ts->pool, &jitc_task_head(ts), 1, blocks,
+                [](uint32_t, void *ptr) {
+                    NumaSchedule *s = (NumaSchedule *) ptr;
+                    jitc_llvm_kernel_callback(jitc_numa_schedule_claim(s),
+                                              s->payload());
+                },
+                sched, 0, jitc_numa_schedule_free
+            );
+        } else {
+            ret_task = task_submit_dep(
+                ts->pool, &jitc_task_head(ts), 1, blocks,
+                jitc_llvm_kernel_callback, kernel_params.data(),
+                (uint32_t) (kernel_params.size() * sizeof(void *)),
+                nullptr
+            );
+        }
 
         if (unlikely(jit_flag(JitFlag::LaunchBlocking)))
             task_wait(ret_task);
@@ -582,6 +1053,9 @@ void jitc_eval(ThreadState *ts) {
     visited.clear();
     schedule.clear();
 
+    bool side_effects = !ts->side_effects.empty() &&
+                        !(jitc_flags() & (uint32_t) JitFlag::Recording);
+
     // Collect variables that must be computed along with their dependencies
     for (int j = 0; j < 2; ++j) {
         auto &source = j == 0 ? ts->scheduled : ts->side_effects;
@@ -650,6 +1124,7 @@ void jitc_eval(ThreadState *ts) {
 
     scoped_set_context_maybe guard2(ts->context);
     scheduled_tasks.clear();
+    uint32_t eval_id = 0;
 
     for (ScheduledGroup &group : schedule_groups) {
         jitc_assemble(ts, group);
@@ -663,21 +1138,24 @@ void jitc_eval(ThreadState *ts) {
     }
 
     if (ts->backend == JitBackend::LLVM) {
+        Task *&task_head = jitc_task_head(ts);
         if (scheduled_tasks.size() == 1) {
-            task_release(jitc_task);
-            jitc_task = scheduled_tasks[0];
+            task_release(task_head);
+            task_head = scheduled_tasks[0];
         } else {
             if (unlikely(scheduled_tasks.empty()))
                 jitc_fail("jit_eval(): no tasks generated!");
 
             // Insert a barrier task
-            Task *new_task = task_submit_dep(nullptr, scheduled_tasks.data(),
+            Task *new_task = task_submit_dep(ts->pool, scheduled_tasks.data(),
                                              (uint32_t) scheduled_tasks.size());
-            task_release(jitc_task);
+            task_release(task_head);
             for (Task *t : scheduled_tasks)
                 task_release(t);
-            jitc_task = new_task;
+            task_head = new_task;
         }
+
+        eval_id = jitc_event_register_eval(ts, task_head, side_effects);
     }
 
     /* Variables and their dependencies are now computed, hence internal edges
@@ -711,6 +1189,7 @@ void jitc_eval(ThreadState *ts) {
         if (v->output_flag && v->size == sv.size) {
             v->kind = (uint32_t) VarKind::Data;
             v->data = sv.data;
+            v->eval_id = eval_id;
             v->output_flag = false;
         }
 
@@ -78,6 +78,9 @@ extern char kernel_name[52];
 /// Are we recording an OptiX kernel?
 extern bool uses_optix;
 
+/// Does the kernel store outputs in the memory of inputs?
+extern bool uses_donations;
+
 /// Size and alignment of auxiliary buffer needed by virtual function calls
 extern int32_t alloca_size;
 extern int32_t alloca_align;
@@ -97,6 +100,18 @@ extern std::vector<ScheduledVariable> schedule;
 /// Groups of variables with the same size
 extern std::vector<ScheduledGroup> schedule_groups;
 
+/**
+ * \brief LLVM: integer variables of the kernel being compiled whose value in
+ * lane \c i equals <tt>value[0] + stride * i</tt>, mapped to \c stride
+ *
+ * These are affine functions of the \c VarKind::Counter node (e.g. \c 2*i+1)
+ * that enable gathers and scatters via contiguous or strided packet accesses.
+ */
+extern tsl::robin_map<uint32_t, int32_t, UInt32Hasher> affine_strides;
+
+/// Largest stride of a gather/scatter lowered into a strided packet access
+#define DRJIT_LLVM_STRIDE_MAX 8
+
 /// Evaluate all computation that is queued on the current thread
 extern void jitc_eval(ThreadState *ts);
 
@@ -107,6 +122,15 @@ extern void jitc_cuda_assemble(ThreadState *ts, ScheduledGroup group,
 /// Used by jitc_eval() to generate LLVM IR source code
 extern void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group);
 
+/**
+ * \brief Check if the gather mask 'mask' is the same in all lanes, ignoring
+ * the \c VarKind::DefaultMask that disables lanes past the end of the array
+ *
+ * Returns \c true in that case and sets \c out to the remaining uniform part
+ * of the mask (or zero if there is none).
+ */
+extern bool jitc_uniform_mask(uint32_t mask, uint32_t *out);
+
 /// Used by jitc_vcall() to generate source code for vcalls
 extern XXH128_hash_t
 jitc_assemble_func(ThreadState *ts, const char *name, uint32_t inst_id,
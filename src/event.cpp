@@ -0,0 +1,318 @@
+/*
+    src/event.cpp -- Completion events that track individual kernel launches
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "event.h"
+#include "var.h"
+#include "log.h"
+#include "llvm_pool.h"
+#include <map>
+#include <algorithm>
+
+/// Maximum number of LLVM evaluations that are tracked individually
+#define DRJIT_EVENT_MAX_RECORDS 4096
+
+struct Event {
+    JitBackend backend;
+
+    /// Reference count (held by the user and by a marker task that hasn't run)
+    std::atomic<uint32_t> ref_count;
+
+    /// LLVM: set by the marker task once all dependencies have finished
+    std::atomic<uint32_t> done;
+
+    /// LLVM: the marker task (or \c nullptr if there was nothing to wait for)
+    Task *task;
+
+    /// CUDA: event recorded into the stream of the creating thread
+    CUevent event;
+};
+
+/// Task and queue associated with an LLVM evaluation
+struct EvalRecord {
+    Task *task;
+    Task **queue;
+};
+
+/// Pending LLVM evaluations, indexed by their ID
+static std::map<uint32_t, EvalRecord> jitc_event_evals;
+
+/// ID of the most recent evaluation
+static uint32_t jitc_event_eval_id = 0;
+
+/// Evaluations up to this ID may have been modified in-place
+static uint32_t jitc_event_write_id = 0;
+
+/// Evaluations up to this ID were dropped from 'jitc_event_evals' early
+static uint32_t jitc_event_evict_id = 0;
+
+static void jitc_event_release(Event *event) {
+    if (event->ref_count.fetch_sub(1) == 1)
+        delete event;
+}
+
+uint32_t jitc_event_register_eval(ThreadState *ts, Task *task,
+                                  bool side_effects) {
+    uint32_t id = ++jitc_event_eval_id;
+    if (side_effects)
+        jitc_event_write_id = id;
+
+    if (jitc_event_evals.size() >= DRJIT_EVENT_MAX_RECORDS) {
+        auto it = jitc_event_evals.begin();
+        jitc_event_evict_id = it->first;
+        task_release(it->second.task);
+        jitc_event_evals.erase(it);
+    }
+
+    task_retain(task);
+    jitc_event_evals[id] = EvalRecord{ task, &jitc_task_head(ts) };
+    return id;
+}
+
+uint32_t jitc_event_last_eval() { return jitc_event_eval_id; }
+
+void jitc_event_synced(Task **queue, uint32_t eval_id) {
+    auto it = jitc_event_evals.begin();
+    while (it != jitc_event_evals.end() && it->first <= eval_id) {
+        if (it->second.queue == queue) {
+            task_release(it->second.task);
+            it = jitc_event_evals.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void jitc_event_shutdown() {
+    for (auto &kv : jitc_event_evals)
+        task_release(kv.second.task);
+    jitc_event_evals.clear();
+    jitc_event_eval_id = jitc_event_write_id = jitc_event_evict_id = 0;
+}
+
+/// Collect the LLVM tasks that must finish before 'index' is available
+static void jitc_event_deps(ThreadState *ts, uint32_t index,
+                            std::vector<Task *> &deps) {
+    if (index == 0) {
+        // All work submitted by the calling thread so far
+        if (jitc_task_head(ts))
+            deps.push_back(jitc_task_head(ts));
+        return;
+    }
+
+    const Variable *v = jitc_var(index);
+    if (v->is_literal())
+        return;
+
+    uint32_t id = v->eval_id;
+    if (id != 0 && id > jitc_event_write_id) {
+        auto it = jitc_event_evals.find(id);
+        if (it != jitc_event_evals.end()) {
+            deps.push_back(it->second.task);
+            return;
+        } else if (id > jitc_event_evict_id) {
+            // The associated queue was synchronized in the meantime
+            return;
+        }
+    }
+
+    /* The variable was produced by some other operation (e.g. a memory copy),
+       or it could have been modified afterwards. Conservatively wait for the
+       current position of every queue. */
+    if (jitc_task)
+        deps.push_back(jitc_task);
+    for (ThreadState *ts2 : state.tss) {
+        if (ts2->backend == JitBackend::LLVM && ts2->task)
+            deps.push_back(ts2->task);
+    }
+}
+
+Event *jitc_event_record(JitBackend backend, uint32_t index) {
+    if (index) {
+        const Variable *v = jitc_var(index);
+        if (unlikely((JitBackend) v->backend != backend))
+            jitc_raise("jit_event_record(): variable r%u belongs to a "
+                       "different backend!", index);
+        jitc_var_eval(index);
+    }
+
+    ThreadState *ts = thread_state(backend);
+    Event *event = new Event();
+    event->backend = backend;
+    event->ref_count = 1;
+    event->done = 0;
+    event->task = nullptr;
+    event->event = nullptr;
+
+    if (backend == JitBackend::CUDA) {
+        /* Streams are processed in order, hence recording the event at the
+           current position of the stream is sufficient (and conservative) */
+        scoped_set_context guard(ts->context);
+        cuda_check(cuEventCreate(&event->event, CU_EVENT_DISABLE_TIMING));
+        cuda_check(cuEventRecord(event->event, ts->stream));
+        return event;
+    }
+
+    std::vector<Task *> deps;
+    jitc_event_deps(ts, index, deps);
+
+    if (deps.empty()) {
+        event->done = 1;
+        return event;
+    }
+
+    // The marker task owns a reference until it has run
+    event->ref_count = 2;
+    event->task = task_submit_dep(
+        nullptr, deps.data(), (uint32_t) deps.size(), 1,
+        [](uint32_t, void *payload) {
+            Event *e = (Event *) payload;
+            e->done.store(1);
+            jitc_event_release(e);
+        },
+        event, 0, nullptr, 1);
+
+    return event;
+}
+
+Event *jitc_event_enqueue(ThreadState *ts, const uint32_t *deps,
+                          uint32_t dep_count, bool wait_queue,
+                          void (*func)(void *), void *payload) {
+    std::vector<Task *> tasks;
+    Task *&head = jitc_task_head(ts);
+    if (head && wait_queue)
+        tasks.push_back(head);
+    for (uint32_t i = 0; i < dep_count; ++i)
+        jitc_event_deps(ts, deps[i], tasks);
+
+    std::sort(tasks.begin(), tasks.end());
+    tasks.erase(std::unique(tasks.begin(), tasks.end()), tasks.end());
+
+    Event *event = new Event();
+    event->backend = JitBackend::LLVM;
+    event->ref_count = 2;
+    event->done = 0;
+    event->event = nullptr;
+
+    struct Payload {
+        void (*func)(void *);
+        void *payload;
+        Event *event;
+    };
+
+    Payload p{ func, payload, event };
+
+    Task *task = task_submit_dep(
+        ts->pool, tasks.data(), (uint32_t) tasks.size(), 1,
+        [](uint32_t, void *payload_) {
+            Payload *p2 = (Payload *) payload_;
+            p2->func(p2->payload);
+            p2->event->done.store(1);
+            jitc_event_release(p2->event);
+        },
+        &p, sizeof(Payload), nullptr, 1);
+
+    /* Subsequent work of the queue must be ordered after the task. When the
+       task doesn't already wait for the queue, insert a barrier task that
+       joins both. The event holds the reference returned above. */
+    Task *new_head;
+    if (head && !wait_queue) {
+        Task *barrier_deps[2] = { head, task };
+        new_head = task_submit_dep(ts->pool, barrier_deps, 2);
+    } else {
+        task_retain(task);
+        new_head = task;
+    }
+
+    task_release(head);
+    head = new_head;
+    event->task = task;
+
+    return event;
+}
+
+void jitc_enqueue_host_func(JitBackend backend, void (*callback)(void *),
+                            void *payload, const uint32_t *deps,
+                            uint32_t dep_count) {
+    for (uint32_t i = 0; i < dep_count; ++i) {
+        if (!deps[i])
+            continue;
+        const Variable *v = jitc_var(deps[i]);
+        if (unlikely((JitBackend) v->backend != backend))
+            jitc_raise("jit_enqueue_host_func(): variable r%u belongs to a "
+                       "different backend!", deps[i]);
+        jitc_var_eval(deps[i]);
+    }
+
+    ThreadState *ts = thread_state(backend);
+    if (backend == JitBackend::CUDA) {
+        // Streams are processed in order, which covers the dependencies
+        scoped_set_context guard(ts->context);
+        cuda_check(cuLaunchHostFunc(ts->stream, callback, payload));
+    } else {
+        jitc_event_destroy(
+            jitc_event_enqueue(ts, deps, dep_count, true, callback, payload));
+    }
+}
+
+int jitc_event_query(Event *event) {
+    if (!event)
+        return 1;
+
+    if (event->backend == JitBackend::CUDA) {
+        CUresult rv = cuEventQuery(event->event);
+        if (rv == CUDA_ERROR_NOT_READY)
+            return 0;
+        cuda_check(rv);
+        return 1;
+    }
+
+    return (int) event->done.load();
+}
+
+void jitc_event_wait(Event *event) {
+    if (!event)
+        return;
+
+    unlock_guard guard(state.lock);
+    if (event->backend == JitBackend::CUDA)
+        cuda_check(cuEventSynchronize(event->event));
+    else if (event->task)
+        task_wait(event->task);
+}
+
+void jitc_event_destroy(Event *event) {
+    if (!event)
+        return;
+
+    if (event->backend == JitBackend::CUDA) {
+        cuda_check(cuEventDestroy(event->event));
+        event->event = nullptr;
+    } else if (event->task) {
+        task_release(event->task);
+        event->task = nullptr;
+    }
+
+    jitc_event_release(event);
+}
+
+int jitc_var_ready(uint32_t index) {
+    if (index == 0)
+        return 1;
+
+    const Variable *v = jitc_var(index);
+    if (v->is_literal())
+        return 1;
+    else if (!v->is_data() || v->is_dirty())
+        return 0;
+
+    Event *event = jitc_event_record((JitBackend) v->backend, index);
+    int rv = jitc_event_query(event);
+    jitc_event_destroy(event);
+    return rv;
+}
@@ -0,0 +1,69 @@
+/*
+    src/event.h -- Completion events that track individual kernel launches
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include "internal.h"
+
+struct Event;
+
+/// Create an event that completes once the producer of 'index' has finished
+extern Event *jitc_event_record(JitBackend backend, uint32_t index);
+
+/// Check if an event has completed (does not block)
+extern int jitc_event_query(Event *event);
+
+/// Wait for an event to complete (temporarily releases the lock)
+extern void jitc_event_wait(Event *event);
+
+/// Release an event created by \ref jitc_event_record()
+extern void jitc_event_destroy(Event *event);
+
+/**
+ * \brief Run <tt>func(payload)</tt> on the LLVM thread pool once the producers
+ * of the (evaluated) variables <tt>deps[0..dep_count-1]</tt> have finished
+ *
+ * When \c wait_queue is \c true, the task additionally waits for all work
+ * previously queued by \c ts. In either case, subsequent work of \c ts
+ * (including the reuse of memory that is freed in the meantime) is ordered
+ * after it. Returns an event that completes after \c func has run.
+ */
+extern Event *jitc_event_enqueue(ThreadState *ts, const uint32_t *deps,
+                                 uint32_t dep_count, bool wait_queue,
+                                 void (*func)(void *), void *payload);
+
+/// Enqueue a host callback that runs once 'deps' are computed (see jit.h)
+extern void jitc_enqueue_host_func(JitBackend backend, void (*callback)(void *),
+                                   void *payload, const uint32_t *deps,
+                                   uint32_t dep_count);
+
+/// Check if the variable 'index' is evaluated and its contents are available
+extern int jitc_var_ready(uint32_t index);
+
+/**
+ * \brief Register the task that concludes an LLVM \ref jitc_eval() call
+ *
+ * Returns an ID that \ref jitc_eval() stores in the \c eval_id field of the
+ * variables it computed. \ref jitc_event_record() later uses it to wait for
+ * the launches that produced a particular variable (which are ordered after
+ * earlier work of the same queue) instead of the current end of the queue.
+ * When the evaluation includes side effects, variables computed by earlier
+ * calls could have been modified, and their IDs become stale.
+ */
+extern uint32_t jitc_event_register_eval(ThreadState *ts, Task *task,
+                                         bool side_effects);
+
+/// Forget about evaluations up to 'eval_id' that were appended to 'queue'
+extern void jitc_event_synced(Task **queue, uint32_t eval_id);
+
+/// Return the ID of the most recent evaluation
+extern uint32_t jitc_event_last_eval();
+
+/// Release all tasks referenced by this module
+extern void jitc_event_shutdown();
@@ -14,6 +14,11 @@
 #include "registry.h"
 #include "var.h"
 #include "profiler.h"
+#include "numa.h"
+#include "llvm_pool.h"
+#include "event.h"
+#include "vcall.h"
+#include "shard.h"
 #include <sys/stat.h>
 
 #if defined(DRJIT_ENABLE_OPTIX)
@@ -116,14 +121,26 @@ void jitc_init(uint32_t backends) {
                 temp_path, strerror(errno));
     }
 
+    // Optionally load a bundle of precompiled kernels
+    const char *kernel_pack = getenv("DRJIT_KERNEL_PACK");
+    if (kernel_pack && kernel_pack[0] != '\0') {
+        try {
+            jitc_kernel_pack_load(kernel_pack);
+        } catch (const std::exception &e) {
+            jitc_log(Warn, "jit_init(): %s", e.what());
+        }
+    }
+
     // Enumerate CUDA devices and collect suitable ones
     jitc_log(Info, "jit_init(): detecting devices ..");
 
     if ((backends & ~state.backends) == 0)
         return;
 
-    if ((backends & (uint32_t) JitBackend::LLVM) && jitc_llvm_init())
+    if ((backends & (uint32_t) JitBackend::LLVM) && jitc_llvm_init()) {
         state.backends |= (uint32_t) JitBackend::LLVM;
+        jitc_numa_init();
+    }
 
     if ((backends & (uint32_t) JitBackend::CUDA) && jitc_cuda_init())
         state.backends |= (uint32_t) JitBackend::CUDA;
@@ -171,6 +188,14 @@ void jitc_shutdown(int light) {
         jitc_task = nullptr;
     }
 
+    for (ThreadState *ts : state.tss) {
+        if (ts->backend == JitBackend::LLVM && ts->task) {
+            task_wait_and_release(ts->task);
+            ts->task = nullptr;
+        }
+    }
+    jitc_llvm_free_async_wait();
+
     if (!state.kernel_cache.empty()) {
         jitc_log(Info, "jit_shutdown(): releasing %zu kernel%s ..",
                 state.kernel_cache.size(),
@@ -184,6 +209,7 @@ void jitc_shutdown(int light) {
         state.kernel_cache.clear();
     }
 
+    jitc_kernel_pack_unload();
     state.kernel_history.clear();
 
     // CUDA: Try to already free some memory asynchronously (faster)
@@ -254,6 +280,8 @@ void jitc_shutdown(int light) {
                            "elimination cache leak (see above).");
         }
 
+        jitc_event_shutdown();
+        jitc_llvm_pool_shutdown();
         pool_destroy();
         state.tss.clear();
     }
@@ -305,11 +333,13 @@ void jitc_shutdown(int light) {
     }
 
     jitc_registry_shutdown();
+    jitc_vcall_profile_clear();
     jitc_malloc_shutdown();
 
     jitc_log(Info, "jit_shutdown(light=%u): done", (uint32_t) light);
 
     if (light == 0) {
+        jitc_shard_shutdown();
         jitc_llvm_shutdown();
         jitc_cuda_shutdown();
 #if defined(DRJIT_ENABLE_OPTIX)
@@ -447,16 +477,28 @@ void jitc_sync_thread(ThreadState *ts) {
         scoped_set_context guard(ts->context);
         cuda_check(cuStreamSynchronize(ts->stream));
     } else {
-        task_wait_and_release(jitc_task);
-        jitc_task = nullptr;
+        jitc_llvm_sync(ts);
     }
 }
 
+/* Report cancelled kernels to the thread that launched them. This is only
+   done by the public API wrappers so that internal synchronization points
+   always run to completion and release their resources. */
+void jitc_llvm_check_cancelled(const char *func) {
+    ThreadState *ts = thread_state_llvm;
+    if (ts && unlikely(ts->cancel.cancelled.exchange(0)))
+        jitc_raise("%s(): kernels launched by this thread were cancelled or "
+                   "exceeded their deadline, the contents of the variables "
+                   "evaluated by them are undefined!", func);
+}
+
 /// Wait for all computation on the current stream to finish
 void jitc_sync_thread() {
-    unlock_guard guard(state.lock);
-    jitc_sync_thread(thread_state_cuda);
-    jitc_sync_thread(thread_state_llvm);
+    /* Release lock while synchronizing */ {
+        unlock_guard guard(state.lock);
+        jitc_sync_thread(thread_state_cuda);
+        jitc_sync_thread(thread_state_llvm);
+    }
 }
 
 /// Wait for all computation on the current device to finish
@@ -478,6 +520,7 @@ void jitc_sync_device() {
             if (ts_2->backend == JitBackend::LLVM)
                 jitc_sync_thread(ts_2);
         }
+        jitc_llvm_free_async_wait();
     }
 }
 
@@ -487,6 +530,7 @@ void jitc_sync_all_devices() {
     unlock_guard guard(state.lock);
     for (ThreadState *ts : tss)
         jitc_sync_thread(ts);
+    jitc_llvm_free_async_wait();
 }
 
 static void jitc_rebuild_prefix(ThreadState *ts) {
@@ -664,6 +708,10 @@ KernelHistoryEntry *KernelHistory::get() {
             task_release((Task *) k.task);
             k.task = nullptr;
         }
+
+        if (k.execution_time > 0)
+            k.bandwidth = (float) ((double) (k.bytes_read + k.bytes_written) /
+                                   ((double) k.execution_time * 1e6));
     }
 
     m_data = nullptr;
@@ -16,6 +16,7 @@
 #include "alloc.h"
 #include "io.h"
 #include <deque>
+#include <atomic>
 #include <string.h>
 #include <inttypes.h>
 #include <nanothread/nanothread.h>
@@ -117,6 +118,12 @@ enum VarKind : uint32_t {
     // Extract a component from an operation that produced multiple results
     Extract,
 
+    // Call a function of a module registered via jit_llvm_register_module()
+    ExtCall,
+
+    // Per-lane product with a shared matrix (LLVM)
+    MatVec,
+
     // Denotes the number of different node types
     Count
 };
@@ -180,8 +187,8 @@ struct Variable {
     /// Number of entries
     uint32_t size;
 
-    /// Unused, to be eventually used to upgrade to 64 bit array sizes
-    uint32_t unused;
+    /// LLVM: ID of the \ref jitc_eval() call that computed this variable
+    uint32_t eval_id;
 
     // ================  Essential flags used in the LVN key  =================
 
@@ -231,8 +238,11 @@ struct Variable {
     /// Is this variable marked as an output?
     uint32_t output_flag : 1;
 
+    /// LLVM: is the value the same in all lanes? (see jitc_assemble_uniform())
+    uint32_t uniform : 1;
+
     /// Unused for now
-    uint32_t unused_2 : 6;
+    uint32_t unused_2 : 5;
 
     /// Offset of the argument in the list of kernel parameters
     uint32_t param_offset;
@@ -431,6 +441,27 @@ struct OptixPipelineData {
 };
 #endif
 
+/**
+ * \brief Cooperative cancellation state of LLVM kernel launches
+ *
+ * Kernel work units check this data structure before running. They are
+ * skipped when their launch was cancelled or when the deadline has passed.
+ * See \ref jit_llvm_cancel() and \ref jit_llvm_set_deadline().
+ */
+struct CancelToken {
+    /// ID of the most recent kernel launch
+    std::atomic<uint64_t> launch_id { 0 };
+
+    /// Launches with an ID up to this value are cancelled
+    std::atomic<uint64_t> cancel_id { 0 };
+
+    /// Absolute deadline in nanoseconds (0: no deadline)
+    std::atomic<uint64_t> deadline { 0 };
+
+    /// Set when a work unit was skipped, see \ref jitc_llvm_check_cancelled()
+    std::atomic<uint32_t> cancelled { 0 };
+};
+
 /// Represents a single stream of a parallel communication
 struct ThreadState {
     /// Backend type
@@ -503,6 +534,23 @@ struct ThreadState {
     // Support for stream-ordered memory allocations (async alloc/free)
     bool memory_pool = false;
 
+    /// ---------------------------- LLVM-specific ----------------------------
+
+    /// Priority class of kernels launched by this thread
+    JitPriority priority = JitPriority::Normal;
+
+    /// Thread pool that runs kernels (\c nullptr: shared default pool)
+    Pool *pool = nullptr;
+
+    /// ID of the pool (see \ref jit_llvm_pool_create(), \c 0: default pool)
+    uint32_t pool_id = 0;
+
+    /// Private task queue, used when 'pool' is not the shared default pool
+    Task *task = nullptr;
+
+    /// Cancellation state of kernels launched by this thread
+    CancelToken cancel;
+
 #if defined(DRJIT_ENABLE_OPTIX)
     /// OptiX pipeline associated with the next kernel launch
     OptixPipelineData *optix_pipeline = nullptr;
@@ -808,6 +856,9 @@ extern void jitc_sync_device();
 /// Wait for all computation on *all devices* to finish
 extern void jitc_sync_all_devices();
 
+/// Raise an exception if kernels of the calling thread were cancelled
+extern void jitc_llvm_check_cancelled(const char *func);
+
 /// Search for a shared library and dlopen it if possible
 void *jitc_find_library(const char *fname, const char *glob_pat,
                         const char *env_var);
@@ -925,4 +976,30 @@ inline bool jitc_is_one(Variable *v) {
     return v->literal == one;
 }
 
+/// Convert a half precision value (given by its bit pattern) to single precision
+inline float jitc_half_to_float(uint16_t value) {
+    uint32_t sign = (uint32_t) (value & 0x8000u) << 16,
+             exp  = (value >> 10) & 0x1Fu,
+             mant = value & 0x3FFu, bits;
+
+    if (exp == 0x1F) { // Infinity or NaN
+        bits = sign | 0x7F800000u | (mant << 13);
+    } else if (exp != 0) { // Normalized number
+        bits = sign | ((exp + 112) << 23) | (mant << 13);
+    } else if (mant != 0) { // Denormalized number, renormalize
+        exp = 113;
+        while ((mant & 0x400u) == 0) {
+            mant <<= 1;
+            exp--;
+        }
+        bits = sign | (exp << 23) | ((mant & 0x3FFu) << 13);
+    } else { // Zero
+        bits = sign;
+    }
+
+    float result;
+    memcpy(&result, &bits, sizeof(float));
+    return result;
+}
+
 extern const char *var_kind_name[(int) VarKind::Count];
@@ -13,12 +13,16 @@
 #include "profiler.h"
 #include "cuda.h"
 #include "optix.h"
+#include "llvm_pool.h"
 #include "../resources/kernels.h"
 #include <stdexcept>
 #include <stdio.h>
 #include <fcntl.h>
 #include <errno.h>
 #include <lz4.h>
+#include <algorithm>
+#include <tuple>
+#include <vector>
 
 #if defined(_WIN32)
 #  include <windows.h>
@@ -72,9 +76,20 @@ static uint32_t compute_padding(const CacheFileHeader &header) {
     return padding_size;
 }
 
-bool jitc_kernel_load(const char *source, uint32_t source_size,
-                      JitBackend backend, XXH128_hash_t hash, Kernel &kernel) {
-    jitc_lz4_init();
+/// Load a kernel from the cache directory, or from a kernel pack entry if \c packed is set
+static bool jitc_kernel_load_impl(const char *source, uint32_t source_size,
+                                  JitBackend backend, XXH128_hash_t hash,
+                                  Kernel &kernel, const uint8_t *packed,
+                                  size_t packed_size) {
+    bool in_pack = packed != nullptr;
+
+    auto read_packed = [&](uint8_t *data, size_t data_size) {
+        if (data_size > packed_size)
+            jitc_raise("jit_kernel_load(): kernel pack entry is truncated!");
+        memcpy(data, packed, data_size);
+        packed += data_size;
+        packed_size -= data_size;
+    };
 
 #if !defined(_WIN32)
     char filename[512];
@@ -84,11 +99,16 @@ bool jitc_kernel_load(const char *source, uint32_t source_size,
                           backend == JitBackend::CUDA ? "cuda" : "llvm") < 0))
         jitc_fail("jit_kernel_load(): scratch space for filename insufficient!");
 
-    int fd = open(filename, O_RDONLY);
-    if (fd == -1)
-        return false;
+    int fd = -1;
+    if (!in_pack) {
+        fd = open(filename, O_RDONLY);
+        if (fd == -1)
+            return false;
+    }
 
     auto read_retry = [&](uint8_t* data, size_t data_size) {
+        if (in_pack)
+            return read_packed(data, data_size);
         while (data_size > 0) {
             ssize_t n_read = read(fd, data, data_size);
             if (n_read <= 0) {
@@ -119,14 +139,19 @@ bool jitc_kernel_load(const char *source, uint32_t source_size,
         wcstombs(filename, filename_w, sizeof(filename)) == sizeof(filename))
         jitc_fail("jit_kernel_load(): scratch space for filename insufficient!");
 
-    HANDLE fd = CreateFileW(filename_w, GENERIC_READ,
-        FILE_SHARE_READ, nullptr, OPEN_EXISTING,
-        FILE_ATTRIBUTE_NORMAL, nullptr);
+    HANDLE fd = INVALID_HANDLE_VALUE;
+    if (!in_pack) {
+        fd = CreateFileW(filename_w, GENERIC_READ,
+            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL, nullptr);
 
-    if (fd == INVALID_HANDLE_VALUE)
-        return false;
+        if (fd == INVALID_HANDLE_VALUE)
+            return false;
+    }
 
     auto read_retry = [&](uint8_t* data, size_t data_size) {
+        if (in_pack)
+            return read_packed(data, data_size);
         while (data_size > 0) {
             DWORD n_read = 0;
             if (!ReadFile(fd, data, (DWORD) data_size, &n_read, nullptr) || n_read == 0)
@@ -191,7 +216,10 @@ bool jitc_kernel_load(const char *source, uint32_t source_size,
     }
 
     if (success) {
-        jitc_log(Trace, "jit_kernel_load(\"%s\")", filename);
+        if (in_pack)
+            jitc_log(Trace, "jit_kernel_load(\"%s\"): found in kernel pack", filename);
+        else
+            jitc_log(Trace, "jit_kernel_load(\"%s\")", filename);
         kernel.size = header.kernel_size;
         if (backend == JitBackend::CUDA) {
             kernel.data = malloc_check(header.kernel_size);
@@ -245,14 +273,41 @@ bool jitc_kernel_load(const char *source, uint32_t source_size,
     free(uncompressed);
 
 #if !defined(_WIN32)
-    close(fd);
+    if (fd != -1)
+        close(fd);
 #else
-    CloseHandle(fd);
+    if (fd != INVALID_HANDLE_VALUE)
+        CloseHandle(fd);
 #endif
 
+    if (success)
+        jitc_kernel_pack_record(backend, hash);
+
     return success;
 }
 
+bool jitc_kernel_load(const char *source, uint32_t source_size,
+                      JitBackend backend, XXH128_hash_t hash, Kernel &kernel) {
+    jitc_lz4_init();
+
+    // Kernels in a loaded pack take precedence over the cache directory
+    const uint8_t *packed = nullptr;
+    size_t packed_size = 0;
+    if (jitc_kernel_pack_find(backend, hash, packed, packed_size)) {
+        if (jitc_kernel_load_impl(source, source_size, backend, hash, kernel,
+                                  packed, packed_size))
+            return true;
+
+        jitc_log(Warn, "jit_kernel_load(): could not load kernel "
+                 "%016llx%016llx from the kernel pack, falling back to the "
+                 "cache directory.", (unsigned long long) hash.high64,
+                 (unsigned long long) hash.low64);
+    }
+
+    return jitc_kernel_load_impl(source, source_size, backend, hash, kernel,
+                                 nullptr, 0);
+}
+
 bool jitc_kernel_write(const char *source, uint32_t source_size,
                        JitBackend backend, XXH128_hash_t hash,
                        const Kernel &kernel) {
@@ -423,6 +478,9 @@ bool jitc_kernel_write(const char *source, uint32_t source_size,
                 filename, GetLastError());
 #endif
 
+    if (success)
+        jitc_kernel_pack_record(backend, hash);
+
 #if DRJIT_CACHE_TRAIN == 1
     snprintf(filename, sizeof(filename), "%s/.drjit/%016llx%016llx.%s.trn",
              getenv("HOME"), (unsigned long long) hash.high64,
@@ -478,3 +536,229 @@ void jitc_flush_kernel_cache() {
 
     state.kernel_cache.clear();
 }
+
+// ====================================================================
+//   Kernel packs: cache entries bundled into a single file for deployment
+// ====================================================================
+
+#pragma pack(push)
+#pragma pack(1)
+struct KernelPackHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+};
+
+struct KernelPackEntry {
+    uint64_t hash_high;
+    uint64_t hash_low;
+    uint32_t backend;
+    uint32_t size;
+    uint64_t offset;
+};
+#pragma pack(pop)
+
+static const char jitc_kernel_pack_magic[4] = { 'D', 'R', 'J', 'K' };
+
+/// Kernels that were loaded or compiled by this process (for packing)
+static std::vector<std::pair<XXH128_hash_t, JitBackend>> jitc_kernel_pack_used;
+
+/// Contents of the currently loaded pack, and a hash table referencing it
+static uint8_t *jitc_kernel_pack_data = nullptr;
+static tsl::robin_map<uint64_t, const KernelPackEntry *, UInt64Hasher>
+    jitc_kernel_pack_index;
+
+static uint64_t jitc_kernel_pack_key(JitBackend backend, XXH128_hash_t hash) {
+    return hash.high64 ^ (uint64_t) backend;
+}
+
+void jitc_kernel_pack_record(JitBackend backend, XXH128_hash_t hash) {
+    jitc_kernel_pack_used.emplace_back(hash, backend);
+}
+
+bool jitc_kernel_pack_find(JitBackend backend, XXH128_hash_t hash,
+                           const uint8_t *&data, size_t &size) {
+    if (likely(jitc_kernel_pack_index.empty()))
+        return false;
+
+    auto it = jitc_kernel_pack_index.find(jitc_kernel_pack_key(backend, hash));
+    if (it == jitc_kernel_pack_index.end())
+        return false;
+
+    const KernelPackEntry *e = it->second;
+    if (e->hash_high != hash.high64 || e->hash_low != hash.low64 ||
+        e->backend != (uint32_t) backend)
+        return false;
+
+    data = jitc_kernel_pack_data + e->offset;
+    size = e->size;
+    return true;
+}
+
+uint32_t jitc_kernel_pack_write(const char *path) {
+#if !defined(_WIN32)
+    auto &used = jitc_kernel_pack_used;
+    std::sort(used.begin(), used.end(), [](const auto &a, const auto &b) {
+        return std::make_tuple(a.first.high64, a.first.low64, a.second) <
+               std::make_tuple(b.first.high64, b.first.low64, b.second);
+    });
+    used.erase(std::unique(used.begin(), used.end(),
+                           [](const auto &a, const auto &b) {
+                               return a.first.high64 == b.first.high64 &&
+                                      a.first.low64 == b.first.low64 &&
+                                      a.second == b.second;
+                           }),
+               used.end());
+
+    // Collect the cache files of all kernels
+    std::vector<KernelPackEntry> entries;
+    std::vector<uint8_t> blob;
+
+    for (auto [hash, backend] : used) {
+        char filename[512];
+        if (unlikely(snprintf(filename, sizeof(filename), "%s/%016llx%016llx.%s.bin",
+                              jitc_temp_path, (unsigned long long) hash.high64,
+                              (unsigned long long) hash.low64,
+                              backend == JitBackend::CUDA ? "cuda" : "llvm") < 0))
+            jitc_fail("jit_kernel_pack_write(): scratch space for filename insufficient!");
+
+        FILE *f = fopen(filename, "rb");
+        if (!f) {
+            jitc_log(Warn, "jit_kernel_pack_write(): could not open cache file "
+                     "\"%s\", skipping: %s", filename, strerror(errno));
+            continue;
+        }
+
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+
+        size_t offset = blob.size();
+        blob.resize(offset + (size_t) size);
+        bool success = size > 0 && fread(blob.data() + offset, 1, (size_t) size,
+                                         f) == (size_t) size;
+        fclose(f);
+
+        if (!success) {
+            blob.resize(offset);
+            jitc_log(Warn, "jit_kernel_pack_write(): could not read cache "
+                     "file \"%s\", skipping.", filename);
+            continue;
+        }
+
+        entries.push_back(KernelPackEntry{ hash.high64, hash.low64,
+                                           (uint32_t) backend, (uint32_t) size,
+                                           (uint64_t) offset });
+    }
+
+    KernelPackHeader header;
+    memcpy(header.magic, jitc_kernel_pack_magic, 4);
+    header.version = DRJIT_CACHE_VERSION;
+    header.count = (uint32_t) entries.size();
+
+    FILE *f = fopen(path, "wb");
+    bool success = f != nullptr;
+    if (success) {
+        success &= fwrite(&header, sizeof(KernelPackHeader), 1, f) == 1;
+        success &= fwrite(entries.data(), sizeof(KernelPackEntry),
+                          entries.size(), f) == entries.size();
+        success &= fwrite(blob.data(), 1, blob.size(), f) == blob.size();
+        success &= fclose(f) == 0;
+    }
+
+    if (!success)
+        jitc_raise("jit_kernel_pack_write(): could not write \"%s\": %s", path,
+                   strerror(errno));
+
+    jitc_log(Info, "jit_kernel_pack_write(\"%s\"): wrote %u kernel%s (%s).",
+             path, header.count, header.count == 1 ? "" : "s",
+             jitc_mem_string(sizeof(KernelPackHeader) +
+                             entries.size() * sizeof(KernelPackEntry) +
+                             blob.size()));
+
+    return header.count;
+#else
+    (void) path;
+    jitc_raise("jit_kernel_pack_write(): not supported on Windows!");
+#endif
+}
+
+void jitc_kernel_pack_load(const char *path) {
+    jitc_kernel_pack_unload();
+    if (!path)
+        return;
+
+    uint64_t t0 = jitc_llvm_pool_time();
+    const char *error = nullptr;
+    uint8_t *data = nullptr;
+    size_t size = 0;
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        error = strerror(errno);
+    } else {
+        fseek(f, 0, SEEK_END);
+        long size_l = ftell(f);
+        fseek(f, 0, SEEK_SET);
+
+        if (size_l < (long) sizeof(KernelPackHeader)) {
+            error = "file is too small";
+        } else {
+            size = (size_t) size_l;
+            data = (uint8_t *) malloc_check(size);
+            if (fread(data, 1, size, f) != size)
+                error = "read error";
+        }
+        fclose(f);
+    }
+
+    const KernelPackHeader *header = (const KernelPackHeader *) data;
+    if (!error) {
+        if (memcmp(header->magic, jitc_kernel_pack_magic, 4) != 0)
+            error = "not a kernel pack";
+        else if (header->version != DRJIT_CACHE_VERSION)
+            error = "created by an incompatible version of Dr.Jit";
+        else if (sizeof(KernelPackHeader) +
+                     (size_t) header->count * sizeof(KernelPackEntry) > size)
+            error = "truncated file";
+    }
+
+    if (error) {
+        free(data);
+        jitc_raise("jit_kernel_pack_load(\"%s\"): %s!", path, error);
+    }
+
+    /* Entry offsets are relative to the start of the kernel data, rebase them
+       to the start of the file */
+    size_t base = sizeof(KernelPackHeader) +
+                  (size_t) header->count * sizeof(KernelPackEntry);
+    KernelPackEntry *entries = (KernelPackEntry *) (data + sizeof(KernelPackHeader));
+
+    for (uint32_t i = 0; i < header->count; ++i) {
+        KernelPackEntry &e = entries[i];
+        if (e.offset + e.size > size - base) {
+            jitc_log(Warn, "jit_kernel_pack_load(\"%s\"): entry %u is out of "
+                     "bounds, skipping.", path, i);
+            continue;
+        }
+        e.offset += base;
+        XXH128_hash_t hash;
+        hash.high64 = e.hash_high;
+        hash.low64 = e.hash_low;
+        jitc_kernel_pack_index[jitc_kernel_pack_key((JitBackend) e.backend, hash)] = &e;
+    }
+
+    jitc_kernel_pack_data = data;
+
+    float duration = (jitc_llvm_pool_time() - t0) * 1e-3f;
+    jitc_log(Info, "jit_kernel_pack_load(\"%s\"): indexed %zu kernel%s in %s.",
+             path, jitc_kernel_pack_index.size(),
+             jitc_kernel_pack_index.size() == 1 ? "" : "s",
+             jitc_time_string(duration));
+}
+
+void jitc_kernel_pack_unload() {
+    jitc_kernel_pack_index.clear();
+    free(jitc_kernel_pack_data);
+    jitc_kernel_pack_data = nullptr;
+}
@@ -79,3 +79,19 @@ extern bool jitc_kernel_write(const char *source, uint32_t source_size,
 extern void jitc_kernel_free(int device_id, const Kernel &kernel);
 
 extern void jitc_flush_kernel_cache();
+
+/// Remember that a kernel is available in the cache (for \ref jitc_kernel_pack_write())
+extern void jitc_kernel_pack_record(JitBackend backend, XXH128_hash_t hash);
+
+/// Look up the cache file contents of a kernel in the loaded pack
+extern bool jitc_kernel_pack_find(JitBackend backend, XXH128_hash_t hash,
+                                  const uint8_t *&data, size_t &size);
+
+/// Bundle the kernels used by this process into a single file (see jit.h)
+extern uint32_t jitc_kernel_pack_write(const char *path);
+
+/// Load a file created by \ref jitc_kernel_pack_write() (see jit.h)
+extern void jitc_kernel_pack_load(const char *path);
+
+/// Release the currently loaded kernel pack
+extern void jitc_kernel_pack_unload();
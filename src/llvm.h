@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <drjit-core/jit.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <vector>
@@ -48,6 +49,9 @@ extern uint32_t jitc_llvm_vector_width;
 /// Should the LLVM IR use typed (e.g., "i8*") or untyped ("ptr") pointers?
 extern bool jitc_llvm_opaque_pointers;
 
+/// Does the target support arithmetic on half precision vectors (AVX512-FP16)?
+extern bool jitc_llvm_native_f16;
+
 /// LLVM version (parts can equal -1, which means: not sure)
 extern int jitc_llvm_version_major;
 extern int jitc_llvm_version_minor;
@@ -90,3 +94,29 @@ extern void jitc_llvm_set_target(const char *target_cpu,
 /// Insert a ray tracing function call into the LLVM program
 extern void jitc_llvm_ray_trace(uint32_t func, uint32_t scene, int shadow_ray,
                                 const uint32_t *in, uint32_t *out);
+
+/// Register an LLVM module with functions that kernels may call (see jit.h)
+extern void jitc_llvm_register_module(const void *data, size_t size);
+
+/// Look up a function of a registered module, returns its ID or -1 if missing
+extern int32_t jitc_llvm_ext_lookup(const char *name);
+
+/// Return the name of a function of a registered module
+extern const char *jitc_llvm_ext_name(uint32_t id);
+
+/// Return a hash of the contents of the module that provides a given function
+extern uint64_t jitc_llvm_ext_hash(uint32_t id);
+
+/// Raise if the type of a registered function differs from 'signature'
+extern void jitc_llvm_ext_check(uint32_t id, const char *signature);
+
+/// Set when the kernel being assembled calls a registered function
+extern bool jitc_llvm_ext_used;
+
+/// Insert a call to a function of a registered LLVM module
+extern uint32_t jitc_llvm_call(const char *name, VarType type, uint32_t n_args,
+                               const uint32_t *args);
+
+/// Multiply the vectors 'in' by a shared matrix (see jit.h)
+extern void jitc_llvm_matvec(uint32_t weights, uint32_t bias, uint32_t rows,
+                             uint32_t cols, const uint32_t *in, uint32_t *out);
@@ -120,11 +120,25 @@ bool jitc_llvm_api_init() {
     LOAD(core, LLVMRunPassManager);
     LOAD(core, LLVMDisposePassManager);
     LOAD(core, LLVMAddLICMPass);
+    LOAD(core, LLVMAddAlwaysInlinerPass);
     LOAD(core, LLVMPassManagerBuilderCreate);
     LOAD(core, LLVMPassManagerBuilderSetOptLevel);
     LOAD(core, LLVMPassManagerBuilderPopulateModulePassManager);
     LOAD(core, LLVMPassManagerBuilderDispose);
     LOAD(core, LLVMVerifyModule);
+    LOAD(core, LLVMCloneModule);
+    LOAD(core, LLVMLinkModules2);
+    LOAD(core, LLVMGetFirstFunction);
+    LOAD(core, LLVMGetNextFunction);
+    LOAD(core, LLVMGetFirstGlobal);
+    LOAD(core, LLVMGetNextGlobal);
+    LOAD(core, LLVMGetNamedFunction);
+    LOAD(core, LLVMGetNamedGlobal);
+    LOAD(core, LLVMIsDeclaration);
+    LOAD(core, LLVMGetValueName);
+    LOAD(core, LLVMSetLinkage);
+    LOAD(core, LLVMGlobalGetValueType);
+    LOAD(core, LLVMPrintTypeToString);
 
     LOAD(version, LLVMGetVersion);
 
@@ -256,11 +270,25 @@ void jitc_llvm_api_shutdown() {
     CLEAR(LLVMRunPassManager);
     CLEAR(LLVMDisposePassManager);
     CLEAR(LLVMAddLICMPass);
+    CLEAR(LLVMAddAlwaysInlinerPass);
     CLEAR(LLVMPassManagerBuilderCreate);
     CLEAR(LLVMPassManagerBuilderSetOptLevel);
     CLEAR(LLVMPassManagerBuilderPopulateModulePassManager);
     CLEAR(LLVMPassManagerBuilderDispose);
     CLEAR(LLVMVerifyModule);
+    CLEAR(LLVMCloneModule);
+    CLEAR(LLVMLinkModules2);
+    CLEAR(LLVMGetFirstFunction);
+    CLEAR(LLVMGetNextFunction);
+    CLEAR(LLVMGetFirstGlobal);
+    CLEAR(LLVMGetNextGlobal);
+    CLEAR(LLVMGetNamedFunction);
+    CLEAR(LLVMGetNamedGlobal);
+    CLEAR(LLVMIsDeclaration);
+    CLEAR(LLVMGetValueName);
+    CLEAR(LLVMSetLinkage);
+    CLEAR(LLVMGlobalGetValueType);
+    CLEAR(LLVMPrintTypeToString);
 
     // Version
     CLEAR(LLVMGetVersion);
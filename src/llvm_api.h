@@ -30,6 +30,8 @@
 #  include <llvm-c/IRReader.h>
 #  include <llvm-c/Analysis.h>
 #  include <llvm-c/Transforms/Scalar.h>
+#  include <llvm-c/Transforms/IPO.h>
+#  include <llvm-c/Linker.h>
 #  include <llvm-c/LLJIT.h>
 #  include <llvm-c/OrcEE.h>
 #else
@@ -41,12 +43,15 @@
 #  define LLVMCodeGenLevelAggressive 3
 #  define LLVMRelocPIC 2
 #  define LLVMCodeModelSmall 3
+#  define LLVMInternalLinkage 8
 
 /// LLVM API
 using LLVMBool = int;
 using LLVMDisasmContextRef = void *;
 using LLVMExecutionEngineRef = void *;
 using LLVMModuleRef = void *;
+using LLVMValueRef = void *;
+using LLVMTypeRef = void *;
 using LLVMMemoryBufferRef = void *;
 using LLVMContextRef = void *;
 using LLVMPassManagerRef = void *;
@@ -127,6 +132,7 @@ DR_LLVM_SYM(LLVMPassManagerRef (*LLVMCreatePassManager)());
 DR_LLVM_SYM(void (*LLVMRunPassManager)(LLVMPassManagerRef, LLVMModuleRef));
 DR_LLVM_SYM(void (*LLVMDisposePassManager)(LLVMPassManagerRef));
 DR_LLVM_SYM(void (*LLVMAddLICMPass)(LLVMPassManagerRef));
+DR_LLVM_SYM(void (*LLVMAddAlwaysInlinerPass)(LLVMPassManagerRef));
 DR_LLVM_SYM(LLVMPassManagerBuilderRef (*LLVMPassManagerBuilderCreate)());
 DR_LLVM_SYM(void (*LLVMPassManagerBuilderSetOptLevel)(LLVMPassManagerBuilderRef,
                                                       unsigned));
@@ -134,6 +140,19 @@ DR_LLVM_SYM(void (*LLVMPassManagerBuilderPopulateModulePassManager)(
     LLVMPassManagerBuilderRef, LLVMPassManagerRef));
 DR_LLVM_SYM(void (*LLVMPassManagerBuilderDispose)(LLVMPassManagerBuilderRef));
 DR_LLVM_SYM(bool (*LLVMVerifyModule)(LLVMModuleRef, int action, char **msg));
+DR_LLVM_SYM(LLVMModuleRef (*LLVMCloneModule)(LLVMModuleRef));
+DR_LLVM_SYM(LLVMBool (*LLVMLinkModules2)(LLVMModuleRef, LLVMModuleRef));
+DR_LLVM_SYM(LLVMValueRef (*LLVMGetFirstFunction)(LLVMModuleRef));
+DR_LLVM_SYM(LLVMValueRef (*LLVMGetNextFunction)(LLVMValueRef));
+DR_LLVM_SYM(LLVMValueRef (*LLVMGetFirstGlobal)(LLVMModuleRef));
+DR_LLVM_SYM(LLVMValueRef (*LLVMGetNextGlobal)(LLVMValueRef));
+DR_LLVM_SYM(LLVMValueRef (*LLVMGetNamedFunction)(LLVMModuleRef, const char *));
+DR_LLVM_SYM(LLVMValueRef (*LLVMGetNamedGlobal)(LLVMModuleRef, const char *));
+DR_LLVM_SYM(LLVMBool (*LLVMIsDeclaration)(LLVMValueRef));
+DR_LLVM_SYM(const char *(*LLVMGetValueName)(LLVMValueRef));
+DR_LLVM_SYM(void (*LLVMSetLinkage)(LLVMValueRef, int));
+DR_LLVM_SYM(LLVMTypeRef (*LLVMGlobalGetValueType)(LLVMValueRef));
+DR_LLVM_SYM(char *(*LLVMPrintTypeToString)(LLVMTypeRef));
 DR_LLVM_SYM(void (*LLVMGetVersion)(unsigned *, unsigned *, unsigned *));
 
 // API for MCJIT interface
@@ -46,12 +46,33 @@ uint32_t jitc_llvm_vector_width = 0;
 /// Should the LLVM IR use typed (e.g., "i8*") or untyped ("ptr") pointers?
 bool jitc_llvm_opaque_pointers = false;
 
+/// Does the target support arithmetic on half precision vectors (AVX512-FP16)?
+bool jitc_llvm_native_f16 = false;
+
 /// Strings related to the vector width, used by template engine
 char **jitc_llvm_ones_str = nullptr;
 
 /// Current top-level task in the task queue
 Task *jitc_task = nullptr;
 
+/// Precompiled LLVM module registered via jitc_llvm_register_module()
+struct LLVMExtModule {
+    LLVMModuleRef module;
+    size_t size;
+    uint64_t hash;
+
+    /// Names of the functions and global variables defined by the module
+    std::vector<std::string> funcs, globals;
+};
+
+static std::vector<LLVMExtModule> jitc_llvm_ext_modules;
+
+/// Functions provided by registered modules (name and index of the module)
+static std::vector<std::pair<std::string, uint32_t>> jitc_llvm_ext_funcs;
+
+/// Set when the kernel being assembled calls a registered function
+bool jitc_llvm_ext_used = false;
+
 void jitc_llvm_update_strings();
 
 bool jitc_llvm_init() {
@@ -88,6 +109,8 @@ bool jitc_llvm_init() {
     LLVMPassManagerBuilderPopulateModulePassManager(pm_builder, jitc_llvm_pass_manager);
     LLVMPassManagerBuilderDispose(pm_builder);
 #else
+    // Expands devirtualized calls to dominant vcall instances
+    LLVMAddAlwaysInlinerPass(jitc_llvm_pass_manager);
     LLVMAddLICMPass(jitc_llvm_pass_manager);
 #endif
 
@@ -122,6 +145,8 @@ bool jitc_llvm_init() {
     if (strstr(jitc_llvm_target_features, "+avx512vl"))
         jitc_llvm_vector_width = 16;
 
+    jitc_llvm_native_f16 = strstr(jitc_llvm_target_features, "+avx512fp16");
+
 #if defined(__APPLE__) && defined(__aarch64__)
     jitc_llvm_vector_width = 4;
     LLVMDisposeMessage(jitc_llvm_target_cpu);
@@ -182,6 +207,12 @@ void jitc_llvm_shutdown() {
     jitc_llvm_orcv2_shutdown();
     jitc_llvm_mcjit_shutdown();
 
+    for (LLVMExtModule &m : jitc_llvm_ext_modules)
+        LLVMDisposeModule(m.module);
+    jitc_llvm_ext_modules.clear();
+    jitc_llvm_ext_funcs.clear();
+    jitc_llvm_ext_used = false;
+
     LLVMDisposeMessage(jitc_llvm_target_triple);
     LLVMDisposeMessage(jitc_llvm_target_cpu);
     LLVMDisposeMessage(jitc_llvm_target_features);
@@ -196,6 +227,7 @@ void jitc_llvm_shutdown() {
     jitc_llvm_target_cpu = nullptr;
     jitc_llvm_target_features = nullptr;
     jitc_llvm_vector_width = 0;
+    jitc_llvm_native_f16 = false;
     jitc_llvm_context = nullptr;
 
     if (jitc_llvm_ones_str) {
@@ -236,8 +268,9 @@ void jitc_llvm_update_strings() {
 
             if (vt == VarType::Bool)
                 buf.put('1');
-            else if (vt == VarType::Float16 || vt == VarType::Float32 ||
-                     vt == VarType::Float64){
+            else if (vt == VarType::Float16)
+                buf.put("0xHFFFF");
+            else if (vt == VarType::Float32 || vt == VarType::Float64) {
                 buf.put("0x");
                 for (uint32_t k = 0; k < 16; ++k)
                     buf.put(k < 2 * type_size[i] ? 'F' : '0');
@@ -272,6 +305,9 @@ void jitc_llvm_set_target(const char *target_cpu,
     if (target_features)
         jitc_llvm_target_features = LLVMCreateMessage((char *) target_features);
 
+    jitc_llvm_native_f16 =
+        target_features && strstr(target_features, "+avx512fp16");
+
     jitc_llvm_update_strings();
 }
 
@@ -323,7 +359,13 @@ static ProfilerRegion profiler_region_llvm_compile("jit_llvm_compile");
 void jitc_llvm_compile(Kernel &kernel) {
     ProfilerPhase phase(profiler_region_llvm_compile);
 
-    jitc_llvm_memmgr_prepare(buffer.size());
+    size_t ext_size = 0;
+    if (jitc_llvm_ext_used) {
+        for (const LLVMExtModule &m : jitc_llvm_ext_modules)
+            ext_size += m.size;
+    }
+
+    jitc_llvm_memmgr_prepare(buffer.size() + ext_size);
 
     LLVMMemoryBufferRef llvm_buf = LLVMCreateMemoryBufferWithMemoryRange(
         buffer.get(), buffer.size(), kernel_name, 0);
@@ -348,6 +390,30 @@ void jitc_llvm_compile(Kernel &kernel) {
 #endif
     LLVMDisposeMessage(error);
 
+    if (jitc_llvm_ext_used) {
+        /* Link copies of the registered modules into the kernel. Their
+           definitions become private to the kernel so that the always-inliner
+           can expand them and other kernels don't see duplicate symbols. */
+        for (const LLVMExtModule &m : jitc_llvm_ext_modules) {
+            if (LLVMLinkModules2(llvm_module, LLVMCloneModule(m.module)))
+                jitc_fail("jit_llvm_compile(): could not link a module "
+                          "registered via jit_llvm_register_module()!");
+        }
+
+        for (const LLVMExtModule &m : jitc_llvm_ext_modules) {
+            for (const std::string &name : m.funcs) {
+                LLVMValueRef f = LLVMGetNamedFunction(llvm_module, name.c_str());
+                if (f)
+                    LLVMSetLinkage(f, LLVMInternalLinkage);
+            }
+            for (const std::string &name : m.globals) {
+                LLVMValueRef g = LLVMGetNamedGlobal(llvm_module, name.c_str());
+                if (g)
+                    LLVMSetLinkage(g, LLVMInternalLinkage);
+            }
+        }
+    }
+
     LLVMRunPassManager(jitc_llvm_pass_manager, llvm_module);
 
     std::vector<uint8_t *> reloc(
@@ -407,3 +473,112 @@ void jitc_llvm_compile(Kernel &kernel) {
         jitc_fail("jit_llvm_compile(): VirtualProtect() failed: %u", GetLastError());
 #endif
 }
+
+void jitc_llvm_register_module(const void *data, size_t size) {
+    if (!jitc_llvm_init_success)
+        jitc_raise("jit_llvm_register_module(): the LLVM backend is not "
+                   "initialized!");
+    if (!data || !size)
+        jitc_raise("jit_llvm_register_module(): empty module!");
+
+    uint64_t hash = XXH128(data, size, 0).low64;
+    for (const LLVMExtModule &m : jitc_llvm_ext_modules) {
+        if (m.hash == hash && m.size == size)
+            return; // Already registered
+    }
+
+    // The IR parser expects a NUL-terminated buffer
+    char *copy = (char *) malloc_check(size + 1);
+    memcpy(copy, data, size);
+    copy[size] = '\0';
+
+    LLVMMemoryBufferRef llvm_buf = LLVMCreateMemoryBufferWithMemoryRange(
+        copy, size, "drjit_ext_module", 1);
+    if (unlikely(!llvm_buf)) {
+        free(copy);
+        jitc_raise("jit_llvm_register_module(): could not create memory buffer!");
+    }
+
+    // 'llvm_buf' is consumed by this function.
+    LLVMModuleRef llvm_module = nullptr;
+    char *error = nullptr;
+    LLVMParseIRInContext(jitc_llvm_context, llvm_buf, &llvm_module, &error);
+    free(copy);
+
+    if (unlikely(error || !llvm_module)) {
+        std::string msg = error ? error : "unknown error";
+        LLVMDisposeMessage(error);
+        jitc_raise("jit_llvm_register_module(): parsing failed: %s", msg.c_str());
+    }
+
+    LLVMExtModule m;
+    m.module = llvm_module;
+    m.size = size;
+    m.hash = hash;
+
+    for (LLVMValueRef f = LLVMGetFirstFunction(llvm_module); f;
+         f = LLVMGetNextFunction(f)) {
+        if (!LLVMIsDeclaration(f))
+            m.funcs.push_back(LLVMGetValueName(f));
+    }
+
+    for (LLVMValueRef g = LLVMGetFirstGlobal(llvm_module); g;
+         g = LLVMGetNextGlobal(g)) {
+        if (!LLVMIsDeclaration(g))
+            m.globals.push_back(LLVMGetValueName(g));
+    }
+
+    for (const std::string &name : m.funcs) {
+        if (jitc_llvm_ext_lookup(name.c_str()) >= 0) {
+            LLVMDisposeModule(llvm_module);
+            jitc_raise("jit_llvm_register_module(): function \"%s\" was "
+                       "already registered!", name.c_str());
+        }
+    }
+
+    uint32_t module_index = (uint32_t) jitc_llvm_ext_modules.size();
+    for (const std::string &name : m.funcs)
+        jitc_llvm_ext_funcs.emplace_back(name, module_index);
+
+    jitc_log(Info,
+             "jit_llvm_register_module(): registered %zu function%s (%zu bytes).",
+             m.funcs.size(), m.funcs.size() == 1 ? "" : "s", size);
+
+    jitc_llvm_ext_modules.push_back(std::move(m));
+}
+
+int32_t jitc_llvm_ext_lookup(const char *name) {
+    for (size_t i = 0; i < jitc_llvm_ext_funcs.size(); ++i) {
+        if (jitc_llvm_ext_funcs[i].first == name)
+            return (int32_t) i;
+    }
+    return -1;
+}
+
+const char *jitc_llvm_ext_name(uint32_t id) {
+    return jitc_llvm_ext_funcs[id].first.c_str();
+}
+
+uint64_t jitc_llvm_ext_hash(uint32_t id) {
+    return jitc_llvm_ext_modules[jitc_llvm_ext_funcs[id].second].hash;
+}
+
+void jitc_llvm_ext_check(uint32_t id, const char *signature) {
+    const auto &[name, module_index] = jitc_llvm_ext_funcs[id];
+    LLVMValueRef f = LLVMGetNamedFunction(
+        jitc_llvm_ext_modules[module_index].module, name.c_str());
+    if (unlikely(!f))
+        jitc_fail("jit_llvm_call(): could not find function \"%s\"!",
+                  name.c_str());
+
+    char *type = LLVMPrintTypeToString(LLVMGlobalGetValueType(f));
+    if (strcmp(type, signature) != 0) {
+        std::string type_str = type;
+        LLVMDisposeMessage(type);
+        jitc_raise("jit_llvm_call(): function \"%s\" has type \"%s\", which "
+                   "does not match the call (\"%s\"). Note that the vector "
+                   "width of the callee must equal jit_llvm_vector_width().",
+                   name.c_str(), type_str.c_str(), signature);
+    }
+    LLVMDisposeMessage(type);
+}
@@ -91,12 +91,110 @@ static void jitc_llvm_render_printf(uint32_t index, const Variable *v,
 static void jitc_llvm_render_trace(uint32_t index, const Variable *v,
                                    const Variable *func,
                                    const Variable *scene);
+static void jitc_llvm_render_ext_call(const Variable *v, const Variable *a0,
+                                      const Variable *a1, const Variable *a2,
+                                      const Variable *a3);
+static void jitc_llvm_render_matvec(uint32_t index, const Variable *v,
+                                    const Variable *weights,
+                                    const Variable *bias);
+static bool jitc_llvm_render_f16(const Variable *v, const Variable *a0,
+                                 const Variable *a1, const Variable *a2);
+static void jitc_llvm_render_gather_uniform(const Variable *v,
+                                            const Variable *ptr,
+                                            const Variable *index,
+                                            const Variable *mask);
+static uint32_t jitc_llvm_stride(uint32_t index);
+static void jitc_llvm_render_gather_strided(const Variable *v,
+                                            const Variable *ptr,
+                                            const Variable *index,
+                                            const Variable *mask,
+                                            uint32_t stride,
+                                            const char *suffix);
+static void jitc_llvm_render_scatter_strided(const Variable *v,
+                                             const Variable *ptr,
+                                             const Variable *value,
+                                             const Variable *index,
+                                             const Variable *mask,
+                                             uint32_t stride);
+
+/**
+ * Variables that are the same in all lanes (see jitc_assemble_uniform()) are
+ * computed once in the entry block of the kernel. Their code is generated into
+ * a separate buffer using a vector width of 1, and the variable along with its
+ * operands is temporarily renamed so that this scalar version doesn't clash
+ * with the broadcasted value that is used by the rest of the kernel.
+ */
+static StringBuffer uniform_buffer { 1000 };
+
+/// Registers renamed by jitc_llvm_uniform_begin()
+static uint32_t uniform_regs[5], uniform_reg_count = 0;
+
+/// Offset applied to the renamed registers
+static uint32_t uniform_offset = 0;
+
+/// Vector width of the kernel
+static uint32_t uniform_width = 0;
+
+static void jitc_llvm_uniform_begin(uint32_t index, const Variable *v,
+                                    uint32_t mask) {
+    buffer.swap(uniform_buffer);
+
+    // Pointers are used as-is by the rest of the kernel
+    uniform_reg_count = 0;
+    if (v->type == (uint32_t) VarType::Pointer)
+        return;
+
+    uint32_t deps[4] = { v->dep[0], v->dep[1], v->dep[2], v->dep[3] };
+    if (v->kind == (uint32_t) VarKind::Gather) {
+        deps[0] = v->dep[1];
+        deps[1] = mask;
+        deps[2] = deps[3] = 0;
+    }
+
+    uniform_regs[uniform_reg_count++] = index;
+    for (uint32_t i = 0; i < 4; ++i) {
+        bool found = deps[i] == 0;
+        for (uint32_t j = 0; j < uniform_reg_count && !found; ++j)
+            found = uniform_regs[j] == deps[i];
+        if (!found)
+            uniform_regs[uniform_reg_count++] = deps[i];
+    }
+
+    for (uint32_t i = 0; i < uniform_reg_count; ++i)
+        jitc_var(uniform_regs[i])->reg_index += uniform_offset;
+
+    uniform_width = jitc_llvm_vector_width;
+    jitc_llvm_vector_width = 1;
+}
+
+static void jitc_llvm_uniform_end(const Variable *v) {
+    if (v->type != (uint32_t) VarType::Pointer) {
+        for (uint32_t i = 0; i < uniform_reg_count; ++i)
+            jitc_var(uniform_regs[i])->reg_index -= uniform_offset;
+        jitc_llvm_vector_width = uniform_width;
+
+        // Broadcast the scalar for use by the rest of the kernel
+        fmt("    $v = shufflevector <1 x $t> $s$u, <1 x $t> undef, <$w x i32> $z\n",
+            v, v, type_prefix[v->type], v->reg_index + uniform_offset, v);
+    }
+
+    buffer.swap(uniform_buffer);
+}
 
 void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
     bool print_labels = std::max(state.log_level_stderr,
                                  state.log_level_callback) >= LogLevel::Trace ||
                         (jitc_flags() & (uint32_t) JitFlag::PrintIR);
 
+    /* Inputs and outputs occupy separate memory regions, except when outputs
+       reuse the memory of inputs (see jitc_assemble_donate()) */
+    const char *md_in  = uses_donations ? "" : ", !alias.scope !2",
+               *md_out = uses_donations ? "" : ", !noalias !2";
+
+    jitc_llvm_ext_used = false;
+    uniform_buffer.clear();
+    uniform_offset = group.end - group.start + 1;
+
     fmt("define void @drjit_^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^(i64 %start, i64 "
         "%end, {i8**} noalias %params) #0 ${\n"
         "entry:\n"
@@ -131,6 +229,14 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
             }
         }
 
+        bool uniform = v->uniform;
+        uint32_t uniform_mask = 0;
+        if (uniform) {
+            if (v->kind == (uint32_t) VarKind::Gather)
+                jitc_uniform_mask(v->dep[2], &uniform_mask);
+            jitc_llvm_uniform_begin(index, v, uniform_mask);
+        }
+
         /// Determine source/destination address of input/output parameters
         if (v->param_type == ParamType::Input && size == 1 && vt == VarType::Pointer) {
             // Case 1: load a pointer address from the parameter array
@@ -153,19 +259,18 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
         }
 
         if (likely(v->param_type == ParamType::Input)) {
-            if (v->is_literal())
-                continue;
-
-            if (size != 1) {
+            if (v->is_literal()) {
+                // Pointer literal, its value was loaded above
+            } else if (size != 1) {
                 // Load a packet of values
-                fmt("    $v$s = load $M, {$M*} $v_p5, align $A, !alias.scope !2, !nontemporal !3\n",
-                    v, vt == VarType::Bool ? "_0" : "", v, v, v, v);
+                fmt("    $v$s = load $M, {$M*} $v_p5, align $A$s, !nontemporal !3\n",
+                    v, vt == VarType::Bool ? "_0" : "", v, v, v, v, md_in);
                 if (vt == VarType::Bool)
                     fmt("    $v = trunc $M $v_0 to $T\n", v, v, v, v);
             } else {
                 // Load a scalar value and broadcast it
-                fmt("    $v_0 = load $m, {$m*} $v_p3, align $a, !alias.scope !2\n",
-                    v, v, v, v, v);
+                fmt("    $v_0 = load $m, {$m*} $v_p3, align $a$s\n",
+                    v, v, v, v, v, md_in);
 
                 if (vt == VarType::Bool)
                     fmt("    $v_1 = trunc i8 $v_0 to i1\n", v, v);
@@ -183,6 +288,10 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
                 "    $v = shufflevector $T $v_1, $T undef, <$w x i32> $z\n",
                 v, v, v, v,
                 v, v, v, v);
+        } else if (uniform && v->kind == (uint32_t) VarKind::Gather) {
+            jitc_llvm_render_gather_uniform(
+                v, jitc_var(v->dep[0]), jitc_var(v->dep[1]),
+                uniform_mask ? jitc_var(uniform_mask) : nullptr);
         } else if (!v->is_stmt()) {
             jitc_llvm_render_var(index, v);
         } else {
@@ -191,14 +300,17 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
 
         v = jitc_var(index); // `v` might have been invalidated during its assembly
 
+        if (uniform)
+            jitc_llvm_uniform_end(v);
+
         if (v->param_type == ParamType::Output) {
             if (vt != VarType::Bool) {
-                fmt("    store $V, {$T*} $v_p5, align $A, !noalias !2, !nontemporal !3\n",
-                    v, v, v, v);
+                fmt("    store $V, {$T*} $v_p5, align $A$s, !nontemporal !3\n",
+                    v, v, v, v, md_out);
             } else {
                 fmt("    $v_e = zext $V to $M\n"
-                    "    store $M $v_e, {$M*} $v_p5, align $A, !noalias !2, !nontemporal !3\n",
-                    v, v, v, v, v, v, v, v);
+                    "    store $M $v_e, {$M*} $v_p5, align $A$s, !nontemporal !3\n",
+                    v, v, v, v, v, v, v, v, md_out);
             }
         }
     }
@@ -213,6 +325,15 @@ void jitc_llvm_assemble(ThreadState *ts, ScheduledGroup group) {
         "    ret void\n"
         "}\n");
 
+    // Compute uniform variables once at the top of the function
+    if (uniform_buffer.size() > 0) {
+        size_t suffix_start = buffer.size(),
+               suffix_target = (char *) strchr(buffer.get(), ':') - buffer.get() + 2;
+
+        put(uniform_buffer.get(), uniform_buffer.size());
+        buffer.move_suffix(suffix_start, suffix_target);
+    }
+
     /* The program requires extra memory or uses callables. Insert
        setup code the top of the function to accomplish this */
     if (callable_count > 0 || alloca_size >= 0) {
@@ -425,6 +546,10 @@ static void jitc_llvm_render_var(uint32_t index, Variable *v) {
              *a2 = v->dep[2] ? jitc_var(v->dep[2]) : nullptr,
              *a3 = v->dep[3] ? jitc_var(v->dep[3]) : nullptr;
 
+    if (v->type == (uint32_t) VarType::Float16 && !jitc_llvm_native_f16 &&
+        jitc_llvm_render_f16(v, a0, a1, a2))
+        return;
+
     switch (v->kind) {
         case VarKind::Literal:
             fmt("    $v_1 = insertelement $T undef, $t $l, i32 0\n"
@@ -750,16 +875,22 @@ static void jitc_llvm_render_var(uint32_t index, Variable *v) {
                 if (is_bool) // Temporary change
                     v->type = (uint32_t) VarType::UInt8;
 
-                fmt_intrinsic(
-                    "declare $T @llvm.masked.gather.v$w$h(<$w x {$t*}>, i32, $T, $T)",
-                    v, v, v, a2, v);
-
-                fmt("{    $v_0 = bitcast $<i8*$> $v to $<$t*$>\n|}"
-                     "    $v_1 = getelementptr $t, $<{$t*}$> {$v_0|$v}, $V\n"
-                     "    $v$s = call $T @llvm.masked.gather.v$w$h(<$w x {$t*}> $v_1, i32 $a, $V, $T $z)\n",
-                     v, a0, v,
-                     v, v, v, v, a0, a1,
-                     v, is_bool ? "_2" : "", v, v, v, v, v, a2, v);
+                uint32_t stride = jitc_llvm_stride(v->dep[1]);
+                if (stride) {
+                    jitc_llvm_render_gather_strided(v, a0, a1, a2, stride,
+                                                    is_bool ? "_2" : "");
+                } else {
+                    fmt_intrinsic(
+                        "declare $T @llvm.masked.gather.v$w$h(<$w x {$t*}>, i32, $T, $T)",
+                        v, v, v, a2, v);
+
+                    fmt("{    $v_0 = bitcast $<i8*$> $v to $<$t*$>\n|}"
+                         "    $v_1 = getelementptr $t, $<{$t*}$> {$v_0|$v}, $V\n"
+                         "    $v$s = call $T @llvm.masked.gather.v$w$h(<$w x {$t*}> $v_1, i32 $a, $V, $T $z)\n",
+                         v, a0, v,
+                         v, v, v, v, a0, a1,
+                         v, is_bool ? "_2" : "", v, v, v, v, v, a2, v);
+                }
 
                 if (is_bool) { // Restore
                     v->type = (uint32_t) VarType::Bool;
@@ -821,17 +952,249 @@ static void jitc_llvm_render_var(uint32_t index, Variable *v) {
                 (uint32_t) v->literal, v);
             break;
 
+        case VarKind::ExtCall:
+            jitc_llvm_render_ext_call(v, a0, a1, a2, a3);
+            break;
+
+        case VarKind::MatVec:
+            jitc_llvm_render_matvec(index, v, a0, a1);
+            break;
+
         default:
             jitc_fail("jitc_llvm_render_var(): unhandled node kind \"%s\"!",
                       var_kind_name[(uint32_t) v->kind]);
     }
 }
 
+/**
+ * Half precision values are loaded and stored in 16 bit form. Without native
+ * support for arithmetic on such vectors (AVX512-FP16), arithmetic operations
+ * are instead performed in single precision: the operands are widened
+ * (`vcvtph2ps` on CPUs with the F16C extension), and the result is rounded
+ * back to half precision. This is exact for the basic operations (addition,
+ * subtraction, multiplication, division, square root) since single precision
+ * has more than twice as many significand bits. This does not hold for Fma:
+ * the single precision result is rounded twice and may therefore differ from
+ * a fused half precision operation in the last bit. Spelling this out
+ * avoids per-element library calls that older versions of LLVM emit when
+ * legalizing vectors of type `half`. Returns \c false if the operation
+ * should be rendered as usual.
+ */
+static bool jitc_llvm_render_f16(const Variable *v, const Variable *a0,
+                                 const Variable *a1, const Variable *a2) {
+    const char *op = nullptr, *intrinsic = nullptr;
+    uint32_t n = 0;
+
+    switch (v->kind) {
+        case VarKind::Add: op = "fadd"; n = 2; break;
+        case VarKind::Sub: op = "fsub"; n = 2; break;
+        case VarKind::Mul: op = "fmul"; n = 2; break;
+        case VarKind::Div: op = "fdiv"; n = 2; break;
+        case VarKind::Min: intrinsic = "minnum"; n = 2; break;
+        case VarKind::Max: intrinsic = "maxnum"; n = 2; break;
+        case VarKind::Fma: intrinsic = "fma"; n = 3; break;
+        case VarKind::Sqrt: intrinsic = "sqrt"; n = 1; break;
+        case VarKind::Ceil: intrinsic = "ceil"; n = 1; break;
+        case VarKind::Floor: intrinsic = "floor"; n = 1; break;
+        case VarKind::Round: intrinsic = "nearbyint"; n = 1; break;
+        case VarKind::Trunc: intrinsic = "trunc"; n = 1; break;
+        default: return false;
+    }
+
+    const Variable *args[3] = { a0, a1, a2 };
+    for (uint32_t i = 0; i < n; ++i)
+        fmt("    $v_f$u = fpext $V to <$w x float>\n", v, i, args[i]);
+
+    // Intrinsic declarations must match those of the single precision case
+    if (op) {
+        fmt("    $v_f = $s <$w x float> $v_f0, $v_f1\n", v, op, v, v);
+    } else if (n == 1) {
+        fmt_intrinsic("declare <$w x float> @llvm.$s.v$wf32(<$w x float>)",
+                      intrinsic);
+        fmt("    $v_f = call <$w x float> @llvm.$s.v$wf32(<$w x float> $v_f0)\n",
+            v, intrinsic, v);
+    } else if (n == 2) {
+        fmt_intrinsic("declare <$w x float> @llvm.$s.v$wf32(<$w x float>, <$w x float>)",
+                      intrinsic);
+        fmt("    $v_f = call <$w x float> @llvm.$s.v$wf32(<$w x float> $v_f0, "
+            "<$w x float> $v_f1)\n",
+            v, intrinsic, v, v);
+    } else {
+        fmt_intrinsic("declare <$w x float> @llvm.fma.v$wf32(<$w x float>, "
+                      "<$w x float>, <$w x float>)\n");
+        fmt("    $v_f = call <$w x float> @llvm.fma.v$wf32(<$w x float> $v_f0, "
+            "<$w x float> $v_f1, <$w x float> $v_f2)\n",
+            v, v, v, v);
+    }
+
+    fmt("    $v = fptrunc <$w x float> $v_f to $T\n", v, v, v);
+    return true;
+}
+
+/// Load a value that is the same in all lanes via a scalar memory access
+static void jitc_llvm_render_gather_uniform(const Variable *v,
+                                            const Variable *ptr,
+                                            const Variable *index,
+                                            const Variable *mask) {
+    bool is_bool = v->type == (uint32_t) VarType::Bool;
+
+    // Masked-off lanes load from the start of the array, which is always valid
+    fmt("    $v_0 = extractelement $V, i32 0\n", v, index);
+    if (mask)
+        fmt("    $v_1 = extractelement $V, i32 0\n"
+            "    $v_2 = select i1 $v_1, $t $v_0, $t 0\n",
+            v, mask, v, v, index, v, index);
+
+    fmt("{    $v_3 = bitcast i8* $v to $m*\n|}"
+         "    $v_4 = getelementptr inbounds $m, {$m*} {$v_3|$v}, $t $v_$u\n"
+         "    $v_5 = load $m, {$m*} $v_4, align $a, !alias.scope !2\n",
+         v, ptr, v,
+         v, v, v, v, ptr, index, v, mask ? 2 : 0,
+         v, v, v, v, v);
+
+    if (is_bool)
+        fmt("    $v_6 = trunc i8 $v_5 to i1\n", v, v);
+
+    fmt("    $v_7 = insertelement $T undef, $t $v_$u, i32 0\n",
+        v, v, v, v, is_bool ? 6 : 5);
+
+    if (mask)
+        fmt("    $v = select $V, $T $v_7, $T $z\n", v, mask, v, v, v);
+    else
+        fmt("    $v = bitcast $T $v_7 to $T\n", v, v, v, v);
+}
+
+/// Stride of an affine gather/scatter index (see jitc_assemble_affine()), or 0
+static uint32_t jitc_llvm_stride(uint32_t index) {
+    if (callable_depth > 0)
+        return 0;
+
+    auto it = affine_strides.find(index);
+    if (it == affine_strides.end() || it->second < 1 ||
+        it->second > DRJIT_LLVM_STRIDE_MAX)
+        return 0;
+
+    return (uint32_t) it->second;
+}
+
+/**
+ * Append the shuffle mask <tt><i32 f(0), .., i32 f(n-1)></tt>, where
+ * <tt>f(i) = i * mul / div</tt>. When \c fill is nonzero, entries where \c div
+ * doesn't divide \c i refer to element \c fill instead.
+ */
+static void jitc_llvm_render_shuffle(uint32_t n, uint32_t mul, uint32_t div,
+                                     uint32_t fill) {
+    put('<');
+    for (uint32_t i = 0; i < n; ++i)
+        fmt("i32 $u$s", (fill && i % div) ? fill : i * mul / div,
+            i + 1 < n ? ", " : ">\n");
+}
+
+/**
+ * Compute the address of the first lane of a gather/scatter with an affine
+ * index, and spread the mask so that each lane covers \c stride elements
+ * (only the first of which is accessed)
+ */
+static void jitc_llvm_render_strided_addr(const Variable *v,
+                                          const Variable *ptr,
+                                          const Variable *value,
+                                          const Variable *index,
+                                          const Variable *mask,
+                                          uint32_t stride) {
+    uint32_t width = jitc_llvm_vector_width, count = width * stride;
+
+    fmt("    $v_s0 = extractelement $V, i32 0\n"
+        "{    $v_s1 = bitcast i8* $v to $t*\n|}"
+        "    $v_s2 = getelementptr $t, {$t*} {$v_s1|$v}, $t $v_s0\n"
+        "{    $v_s3 = bitcast $t* $v_s2 to <$u x $t>*\n|}",
+        v, index,
+        v, ptr, value,
+        v, value, value, v, ptr, index, v,
+        v, value, v, count, value);
+
+    if (stride == 1) {
+        fmt("    $v_s4 = bitcast $V to <$w x i1>\n", v, mask);
+    } else {
+        fmt("    $v_s4 = shufflevector $V, <$w x i1> $z, <$u x i32> ",
+            v, mask, count);
+        jitc_llvm_render_shuffle(count, 1, stride, width);
+    }
+}
+
+/// Gather from the addresses <tt>ptr[i0], ptr[i0 + stride], ...</tt>
+static void jitc_llvm_render_gather_strided(const Variable *v,
+                                            const Variable *ptr,
+                                            const Variable *index,
+                                            const Variable *mask,
+                                            uint32_t stride,
+                                            const char *suffix) {
+    uint32_t count = jitc_llvm_vector_width * stride;
+
+    jitc_llvm_render_strided_addr(v, ptr, v, index, mask, stride);
+
+    fmt_intrinsic("declare <$u x $t> @llvm.masked.load.v$u$h.p0{v$u$h|}"
+                  "({<$u x $t>*}, i32, <$u x i1>, <$u x $t>)",
+                  count, v, count, v, count, v,
+                  count, v, count, count, v);
+
+    fmt("    $v_s5 = call <$u x $t> @llvm.masked.load.v$u$h.p0{v$u$h|}"
+        "({<$u x $t>*} {$v_s3|$v_s2}, i32 $a, <$u x i1> $v_s4, <$u x $t> $z)\n",
+        v, count, v, count, v, count, v,
+        count, v, v, v, v, count, v, count, v);
+
+    if (stride == 1) {
+        fmt("    $v$s = bitcast <$u x $t> $v_s5 to $T\n",
+            v, suffix, count, v, v, v);
+    } else {
+        // Extract every stride-th element
+        fmt("    $v$s = shufflevector <$u x $t> $v_s5, <$u x $t> undef, <$w x i32> ",
+            v, suffix, count, v, v, count, v);
+        jitc_llvm_render_shuffle(jitc_llvm_vector_width, stride, 1, 0);
+    }
+}
+
+/// Scatter to the addresses <tt>ptr[i0], ptr[i0 + stride], ...</tt>
+static void jitc_llvm_render_scatter_strided(const Variable *v,
+                                             const Variable *ptr,
+                                             const Variable *value,
+                                             const Variable *index,
+                                             const Variable *mask,
+                                             uint32_t stride) {
+    uint32_t count = jitc_llvm_vector_width * stride;
+
+    jitc_llvm_render_strided_addr(v, ptr, value, index, mask, stride);
+
+    if (stride == 1) {
+        fmt("    $v_s5 = bitcast $V to <$u x $t>\n", v, value, count, value);
+    } else {
+        // Move the value of each lane to the first of its elements
+        fmt("    $v_s5 = shufflevector $V, $T undef, <$u x i32> ",
+            v, value, value, count);
+        jitc_llvm_render_shuffle(count, 1, stride, 0);
+    }
+
+    fmt_intrinsic("declare void @llvm.masked.store.v$u$h.p0{v$u$h|}"
+                  "(<$u x $t>, {<$u x $t>*}, i32, <$u x i1>)",
+                  count, value, count, value, count, value,
+                  count, value, count);
+
+    fmt("    call void @llvm.masked.store.v$u$h.p0{v$u$h|}"
+        "(<$u x $t> $v_s5, {<$u x $t>*} {$v_s3|$v_s2}, i32 $a, <$u x i1> $v_s4)\n",
+        count, value, count, value, count, value, v,
+        count, value, v, v, value, count, v);
+}
+
 static void jitc_llvm_render_scatter(const Variable *v,
                                      const Variable *ptr,
                                      const Variable *value,
                                      const Variable *index,
                                      const Variable *mask) {
+    uint32_t stride = jitc_llvm_stride(v->dep[2]);
+    if (!v->literal && stride && value->type != (uint32_t) VarType::Bool) {
+        jitc_llvm_render_scatter_strided(v, ptr, value, index, mask, stride);
+        return;
+    }
+
     fmt("{    $v_0 = bitcast $<i8*$> $v to $<$t*$>\n|}"
          "    $v_1 = getelementptr $t, $<{$t*}$> {$v_0|$v}, $V\n",
         v, ptr, value,
@@ -846,7 +1209,11 @@ static void jitc_llvm_render_scatter(const Variable *v,
         const char *op, *zero_elem = nullptr, *intrinsic_name = nullptr;
         switch ((ReduceOp) v->literal) {
             case ReduceOp::Add:
-                if (jitc_is_single(value)) {
+                if (value->type == (uint32_t) VarType::Float16) {
+                    op = "fadd";
+                    zero_elem = "half -0.0, ";
+                    intrinsic_name = "v2.fadd.f16";
+                } else if (jitc_is_single(value)) {
                     op = "fadd";
                     zero_elem = "float -0.0, ";
                     intrinsic_name = "v2.fadd.f32";
@@ -1063,11 +1430,12 @@ static void jitc_llvm_render_printf(uint32_t index, const Variable *v,
         Variable *v2 = jitc_var(extra.dep[i]);
         VarType vt = (VarType) v2->type;
 
+        bool promote = vt == VarType::Float16 || vt == VarType::Float32;
         fmt("    $v_$u$s = extractelement $V, i32 $v_idx\n",
-            v, i, vt == VarType::Float32 ? "_0" : "", v2, v);
+            v, i, promote ? "_0" : "", v2, v);
 
-        if (vt == VarType::Float32)
-            fmt("    $v_$u = fpext float $v_$u_0 to double\n", v, i, v, i);
+        if (promote)
+            fmt("    $v_$u = fpext $t $v_$u_0 to double\n", v, i, v2, v, i);
     }
 
     if (callable_depth == 0)
@@ -1083,7 +1451,7 @@ static void jitc_llvm_render_printf(uint32_t index, const Variable *v,
     for (uint32_t i = 0; i < extra.n_dep; ++i) {
         Variable *v2 = jitc_var(extra.dep[i]);
         VarType vt = (VarType) v2->type;
-        if (vt == VarType::Float32)
+        if (vt == VarType::Float16 || vt == VarType::Float32)
             vt = VarType::Float64;
         fmt(", $s $v_$u", type_name_llvm[(int) vt], v, i);
     }
@@ -1174,6 +1542,316 @@ static void jitc_llvm_render_stmt(uint32_t index, const Variable *v, bool in_fun
     put('\n');
 }
 
+uint32_t jitc_llvm_call(const char *name, VarType type, uint32_t n_args,
+                        const uint32_t *args) {
+    int32_t id = jitc_llvm_ext_lookup(name);
+    if (id < 0)
+        jitc_raise("jit_llvm_call(): function \"%s\" is not provided by a "
+                   "module registered via jit_llvm_register_module()!", name);
+
+    if (n_args == 0 || n_args > 4)
+        jitc_raise("jit_llvm_call(): expected 1-4 arguments (got %u)!", n_args);
+
+    if (type == VarType::Void)
+        jitc_raise("jit_llvm_call(): the function must return a value!");
+
+    Variable *v[4] { };
+    bool placeholder = false;
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < n_args; ++i) {
+        if (!args[i])
+            jitc_raise("jit_llvm_call(): arg. %u is uninitialized!", i);
+        v[i] = jitc_var(args[i]);
+        if ((JitBackend) v[i]->backend != JitBackend::LLVM)
+            jitc_raise("jit_llvm_call(): arg. %u must be an LLVM array!", i);
+        size = std::max(size, v[i]->size);
+        placeholder |= (bool) v[i]->placeholder;
+    }
+
+    for (uint32_t i = 0; i < n_args; ++i) {
+        if (v[i]->size != 1 && v[i]->size != size)
+            jitc_raise("jit_llvm_call(): arithmetic involving arrays of "
+                       "incompatible size!");
+    }
+
+    /* Compare against the callee's type as printed by LLVM, e.g.
+       "<8 x float> (<8 x float>, <8 x i32>)". A mismatch would otherwise
+       only be detected when the kernel is compiled. */
+    char signature[256];
+    int pos = snprintf(signature, sizeof(signature), "<%u x %s> (",
+                       jitc_llvm_vector_width, type_name_llvm[(int) type]);
+    for (uint32_t i = 0; i < n_args; ++i)
+        pos += snprintf(signature + pos, sizeof(signature) - pos, "%s<%u x %s>",
+                        i ? ", " : "", jitc_llvm_vector_width,
+                        type_name_llvm[v[i]->type]);
+    snprintf(signature + pos, sizeof(signature) - pos, ")");
+    jitc_llvm_ext_check((uint32_t) id, signature);
+
+    uint32_t result;
+    switch (n_args) {
+        case 1:
+            result = jitc_var_new_node_1(JitBackend::LLVM, VarKind::ExtCall,
+                                         type, size, placeholder, args[0],
+                                         v[0], (uint64_t) id);
+            break;
+
+        case 2:
+            result = jitc_var_new_node_2(JitBackend::LLVM, VarKind::ExtCall,
+                                         type, size, placeholder, args[0],
+                                         v[0], args[1], v[1], (uint64_t) id);
+            break;
+
+        case 3:
+            result = jitc_var_new_node_3(
+                JitBackend::LLVM, VarKind::ExtCall, type, size, placeholder,
+                args[0], v[0], args[1], v[1], args[2], v[2], (uint64_t) id);
+            break;
+
+        default:
+            result = jitc_var_new_node_4(
+                JitBackend::LLVM, VarKind::ExtCall, type, size, placeholder,
+                args[0], v[0], args[1], v[1], args[2], v[2], args[3], v[3],
+                (uint64_t) id);
+            break;
+    }
+
+    jitc_log(Debug, "jit_llvm_call(r%u <- \"%s\", %u arg%s)", result, name,
+             n_args, n_args == 1 ? "" : "s");
+
+    return result;
+}
+
+static void jitc_llvm_render_ext_call(const Variable *v, const Variable *a0,
+                                      const Variable *a1, const Variable *a2,
+                                      const Variable *a3) {
+    const Variable *args[4] { a0, a1, a2, a3 };
+    uint32_t id = (uint32_t) v->literal;
+    const char *name = jitc_llvm_ext_name(id);
+
+    // Ensure that cached kernels are invalidated when the module changes
+    fmt_intrinsic("; external module $Q", jitc_llvm_ext_hash(id));
+
+    size_t tmpoff = buffer.size();
+    fmt("declare $T @\"$s\"(", v, name);
+    for (uint32_t i = 0; i < 4 && args[i]; ++i)
+        fmt("$s$T", i ? ", " : "", args[i]);
+    put(')');
+    jitc_register_global(buffer.get() + tmpoff);
+    buffer.rewind_to(tmpoff);
+
+    // The definition is linked in by jitc_llvm_compile() and inlined there
+    fmt("    $v = call $T @\"$s\"(", v, v, name);
+    for (uint32_t i = 0; i < 4 && args[i]; ++i)
+        fmt("$s$V", i ? ", " : "", args[i]);
+    put(") alwaysinline\n");
+
+    jitc_llvm_ext_used = true;
+}
+
+void jitc_llvm_matvec(uint32_t weights, uint32_t bias, uint32_t rows,
+                      uint32_t cols, const uint32_t *in, uint32_t *out) {
+    if (rows == 0 || cols == 0)
+        jitc_raise("jit_llvm_matvec(): the matrix must be nonempty!");
+
+    const Variable *w = jitc_var(weights);
+    VarType vt = (VarType) w->type;
+    if ((JitBackend) w->backend != JitBackend::LLVM ||
+        (vt != VarType::Float32 && vt != VarType::Float64))
+        jitc_raise("jit_llvm_matvec(): 'weights' must be an LLVM array of type "
+                   "Float32 or Float64!");
+    if ((uint64_t) w->size < (uint64_t) rows * cols)
+        jitc_raise("jit_llvm_matvec(): 'weights' must contain at least %u x %u "
+                   "entries (got %u)!", rows, cols, w->size);
+
+    if (bias) {
+        const Variable *b = jitc_var(bias);
+        if ((JitBackend) b->backend != JitBackend::LLVM ||
+            (VarType) b->type != vt || b->size < rows)
+            jitc_raise("jit_llvm_matvec(): 'bias' must be an array of type %s "
+                       "with at least %u entries!", type_name[(int) vt], rows);
+    }
+
+    bool placeholder = false, dirty = false;
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < cols; ++i) {
+        const Variable *v = jitc_var(in[i]);
+        if ((VarType) v->type != vt || (JitBackend) v->backend != JitBackend::LLVM)
+            jitc_raise("jit_llvm_matvec(): type mismatch for arg. %u (got %s, "
+                       "expected %s)", i, type_name[v->type], type_name[(int) vt]);
+        size = std::max(size, v->size);
+        placeholder |= (bool) v->placeholder;
+        dirty |= v->is_dirty();
+    }
+
+    for (uint32_t i = 0; i < cols; ++i) {
+        const Variable *v = jitc_var(in[i]);
+        if (v->size != 1 && v->size != size)
+            jitc_raise("jit_llvm_matvec(): arithmetic involving arrays of "
+                       "incompatible size!");
+    }
+
+    if (dirty) {
+        jitc_eval(thread_state(JitBackend::LLVM));
+        dirty = false;
+
+        for (uint32_t i = 0; i < cols; ++i)
+            dirty |= jitc_var(in[i])->is_dirty();
+
+        if (dirty)
+            jitc_raise("jit_llvm_matvec(): inputs remain dirty after evaluation!");
+    }
+
+    // The matrix is accessed through pointers to the evaluated arrays
+    Ref w_ptr = steal(jitc_var_pointer(JitBackend::LLVM, jitc_var_ptr(weights),
+                                       weights, 0)),
+        b_ptr;
+    if (bias)
+        b_ptr = steal(jitc_var_pointer(JitBackend::LLVM, jitc_var_ptr(bias),
+                                       bias, 0));
+
+    jitc_log(InfoSym, "jit_llvm_matvec(): %u x %u matrix%s, %u lane%s%s", rows,
+             cols, bias ? " with bias" : "", size, size != 1 ? "s" : "",
+             placeholder ? " (part of a recorded computation)" : "");
+
+    uint64_t payload = (uint64_t) rows | ((uint64_t) cols << 32);
+    Ref index;
+    if (bias)
+        index = steal(jitc_var_new_node_2(
+            JitBackend::LLVM, VarKind::MatVec, VarType::Void, size, placeholder,
+            w_ptr, jitc_var(w_ptr), b_ptr, jitc_var(b_ptr), payload));
+    else
+        index = steal(jitc_var_new_node_1(
+            JitBackend::LLVM, VarKind::MatVec, VarType::Void, size, placeholder,
+            w_ptr, jitc_var(w_ptr), payload));
+
+    Variable *v = jitc_var(index);
+    v->extra = 1;
+
+    Extra &extra = state.extra[index];
+    extra.n_dep = cols;
+    extra.dep = (uint32_t *) malloc_check(sizeof(uint32_t) * cols);
+    for (uint32_t i = 0; i < cols; ++i) {
+        extra.dep[i] = in[i];
+        jitc_var_inc_ref(in[i]);
+    }
+
+    for (uint32_t i = 0; i < rows; ++i)
+        out[i] = jitc_var_new_node_1(JitBackend::LLVM, VarKind::Extract, vt,
+                                     size, placeholder, index, jitc_var(index),
+                                     (uint64_t) i);
+}
+
+/* Per-lane matrix-vector product. The weights are uniform across the lanes of
+   a packet, hence they are loaded as scalars and broadcast instead of being
+   gathered. The generated code loops over the rows of the matrix, and each
+   iteration evaluates a chain of FMAs involving all inputs. The resulting rows
+   are staged in the alloca buffer, which keeps the IR size proportional to
+   'rows + cols' rather than 'rows * cols'. */
+static void jitc_llvm_render_matvec(uint32_t index, const Variable *v,
+                                    const Variable *weights,
+                                    const Variable *bias) {
+    const Extra &extra = state.extra[index];
+    uint32_t rows = (uint32_t) v->literal,
+             cols = (uint32_t) (v->literal >> 32),
+             reg = v->reg_index;
+    const Variable *x0 = jitc_var(extra.dep[0]);
+    uint32_t width = jitc_llvm_vector_width,
+             align = type_size[x0->type] * width;
+
+    alloca_size  = std::max(alloca_size, (int32_t) (rows * align));
+    alloca_align = std::max(alloca_align, (int32_t) align);
+
+    fmt_intrinsic("declare $T @llvm.fma.v$w$h($T, $T, $T)\n",
+                  x0, x0, x0, x0, x0);
+
+    fmt("\n    ; -------- Matrix-vector product ($u x $u) -------\n"
+        "    br label %l$u_pre\n"
+        "\nl$u_pre:\n",
+        rows, cols, reg, reg);
+
+    // Obtain scalar pointers to the weights and bias
+    const Variable *ptrs[2] = { weights, bias };
+    const char *ptr_names[2] = { "w", "b" };
+    for (uint32_t i = 0; i < 2; ++i) {
+        if (!ptrs[i])
+            continue;
+
+        if (callable_depth == 0) {
+            fmt("    $v_$s = bitcast {i8*} $v to {$t*}\n",
+                v, ptr_names[i], ptrs[i], x0);
+        } else {
+            fmt_intrinsic("declare i64 @llvm.experimental.vector.reduce.umax.v$wi64(<$w x i64>)");
+            fmt("    $v_$s_0 = ptrtoint <$w x {i8*}> $v to <$w x i64>\n"
+                "    $v_$s_1 = call i64 @llvm.experimental.vector.reduce.umax.v$wi64(<$w x i64> $v_$s_0)\n"
+                "    $v_$s = inttoptr i64 $v_$s_1 to {$t*}\n",
+                v, ptr_names[i], ptrs[i],
+                v, ptr_names[i], v, ptr_names[i],
+                v, ptr_names[i], v, ptr_names[i], x0);
+        }
+    }
+
+    fmt("{    $v_buf = bitcast i8* %buffer to $T*\n|}"
+         "    br label %l$u_loop\n"
+         "\nl$u_loop:\n"
+         "    $v_row = phi i32 [ 0, %l$u_pre ], [ $v_row_next, %l$u_loop ]\n"
+         "    $v_base = mul i32 $v_row, $u\n",
+        v, x0,
+        reg,
+        reg,
+        v, reg, v, reg,
+        v, v, cols);
+
+    if (bias)
+        fmt("    $v_bp = getelementptr inbounds $t, {$t*} $v_b, i32 $v_row\n"
+            "    $v_bs = load $t, {$t*} $v_bp, align $a\n"
+            "    $v_acc_0_0 = insertelement $T undef, $t $v_bs, i32 0\n"
+            "    $v_acc_0 = shufflevector $T $v_acc_0_0, $T undef, <$w x i32> $z\n",
+            v, x0, x0, v, v,
+            v, x0, x0, v, x0,
+            v, x0, x0, v,
+            v, x0, v, x0);
+
+    for (uint32_t i = 0; i < cols; ++i) {
+        const Variable *xi = jitc_var(extra.dep[i]);
+
+        fmt("    $v_i_$u = add i32 $v_base, $u\n"
+            "    $v_p_$u = getelementptr inbounds $t, {$t*} $v_w, i32 $v_i_$u\n"
+            "    $v_s_$u = load $t, {$t*} $v_p_$u, align $a\n"
+            "    $v_t_$u_0 = insertelement $T undef, $t $v_s_$u, i32 0\n"
+            "    $v_t_$u = shufflevector $T $v_t_$u_0, $T undef, <$w x i32> $z\n",
+            v, i, v, i,
+            v, i, x0, x0, v, v, i,
+            v, i, x0, x0, v, i, x0,
+            v, i, x0, x0, v, i,
+            v, i, x0, v, i, x0);
+
+        if (i == 0 && !bias)
+            fmt("    $v_acc_1 = fmul $T $v_t_0, $V\n", v, x0, v, xi);
+        else
+            fmt("    $v_acc_$u = call $T @llvm.fma.v$w$h($T $v_t_$u, $V, $T $v_acc_$u)\n",
+                v, i + 1, x0, x0, x0, v, i, xi, x0, v, i);
+    }
+
+    fmt("    $v_o = getelementptr inbounds $T, {$T*} {$v_buf|%buffer}, i32 $v_row\n"
+        "    store $T $v_acc_$u, {$T*} $v_o, align $u\n"
+        "    $v_row_next = add i32 $v_row, 1\n"
+        "    $v_done = icmp eq i32 $v_row_next, $u\n"
+        "    br i1 $v_done, label %l$u_end, label %l$u_loop\n"
+        "\nl$u_end:\n",
+        v, x0, x0, v, v,
+        x0, v, cols, x0, v, align,
+        v, v,
+        v, v, rows,
+        v, reg, reg,
+        reg);
+
+    for (uint32_t i = 0; i < rows; ++i)
+        fmt("    $v_out_$u_p = getelementptr inbounds $T, {$T*} {$v_buf|%buffer}, i32 $u\n"
+            "    $v_out_$u = load $T, {$T*} $v_out_$u_p, align $u\n",
+            v, i, x0, x0, v, i,
+            v, i, x0, x0, v, i, align);
+}
+
 void jitc_llvm_ray_trace(uint32_t func, uint32_t scene, int shadow_ray,
                          const uint32_t *in, uint32_t *out) {
     const uint32_t n_args = 14;
@@ -1591,15 +2269,66 @@ void jitc_var_vcall_assemble_llvm(VCall *vcall, uint32_t vcall_reg,
     }
 
     // =====================================================
-    // 3. Perform one call to each unique instance
+    // 3. Directly call the dominant instance (if known)
+    // =====================================================
+
+    const XXH128_hash_t *hot_hash = nullptr;
+    for (uint32_t i = 0; i < vcall->n_inst && vcall->hot_inst; ++i) {
+        if (vcall->inst_id[i] == vcall->hot_inst)
+            hot_hash = &vcall->inst_hash[i];
+    }
+
+    if (hot_hash) {
+        fmt_intrinsic("declare i1 @llvm.experimental.vector.reduce.or.v$wi1(<$w x i1>)");
+
+        fmt("    %u$u_hot_0 = insertelement <$w x i32> undef, i32 $u, i32 0\n"
+            "    %u$u_hot_1 = shufflevector <$w x i32> %u$u_hot_0, <$w x i32> undef, <$w x i32> $z\n"
+            "    %u$u_hot_2 = icmp eq <$w x i32> %r$u, %u$u_hot_1\n"
+            "    %u$u_hot = and <$w x i1> %u$u_hot_2, %p$u\n"
+            "    %u$u_hot_any = call i1 @llvm.experimental.vector.reduce.or.v$wi1(<$w x i1> %u$u_hot)\n"
+            "    br i1 %u$u_hot_any, label %l$u_hot, label %l$u_cold\n"
+            "\nl$u_hot:\n"
+            "    call void @func_$Q$Q(<$w x i1> %u$u_hot",
+            vcall_reg, vcall->hot_inst,
+            vcall_reg, vcall_reg,
+            vcall_reg, self_reg, vcall_reg,
+            vcall_reg, vcall_reg, mask_reg,
+            vcall_reg, vcall_reg,
+            vcall_reg, vcall_reg, vcall_reg,
+            vcall_reg,
+            hot_hash->high64, hot_hash->low64, vcall_reg);
+
+        if (vcall->use_self)
+            fmt(", <$w x i32> %r$u", self_reg);
+
+        fmt(", {i8*} %buffer");
+
+        if (data_reg)
+            fmt(", $<{i8*}$> %rd$u, <$w x i32> %u$u_offset", data_reg, vcall_reg);
+
+        // Ask the always-inliner pass to expand the callee at this site
+        fmt(") alwaysinline\n"
+            "    br label %l$u_cold\n"
+            "\nl$u_cold:\n"
+            "    %u$u_self_cold = select <$w x i1> %u$u_hot, <$w x i32> $z, <$w x i32> %u$u_self_initial\n",
+            vcall_reg, vcall_reg, vcall_reg, vcall_reg, vcall_reg);
+
+        jitc_log(InfoSym,
+                 "jit_var_vcall_assemble(): devirtualized the dominant "
+                 "instance %u of call \"%s\".", vcall->hot_inst, vcall->name);
+    }
+
+    // =====================================================
+    // 4. Perform one call to each remaining unique instance
     // =====================================================
 
     fmt("    br label %l$u_check\n"
         "\nl$u_check:\n"
-        "    %u$u_self = phi <$w x i32> [ %u$u_self_initial, %l$u_start ], [ %u$u_self_next, %l$u_call ]\n",
+        "    %u$u_self = phi <$w x i32> [ %u$u_self_$s, %l$u_$s ], [ %u$u_self_next, %l$u_call ]\n",
         vcall_reg,
         vcall_reg,
-        vcall_reg, vcall_reg, vcall_reg, vcall_reg, vcall_reg);
+        vcall_reg, vcall_reg, hot_hash ? "cold" : "initial",
+        vcall_reg, hot_hash ? "cold" : "start", vcall_reg, vcall_reg);
 
     fmt("    %u$u_next = call i32 @llvm.experimental.vector.reduce.umax.v$wi32(<$w x i32> %u$u_self)\n"
         "    %u$u_valid = icmp ne i32 %u$u_next, 0\n"
@@ -0,0 +1,459 @@
+/*
+    src/llvm_pool.cpp -- Thread pools and task queues of the LLVM backend
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "llvm_pool.h"
+#include "log.h"
+#include "event.h"
+#include "cow.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#  include <sys/resource.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+uint32_t jitc_llvm_private_queues = 0;
+
+/// Bookkeeping for an LLVM thread pool
+struct LLVMPool {
+    /// nanothread pool (\c nullptr for the default pool)
+    Pool *pool = nullptr;
+
+    /// Number of worker threads
+    uint32_t size = 0;
+
+    /// Was the pool created by the user (vs. for a priority class)?
+    bool user = false;
+
+    /// Number of launches
+    uint64_t launches = 0;
+
+    /// Number of processed work units and the time spent on them
+    std::atomic<uint64_t> work_units { 0 }, busy_ns { 0 };
+
+    /// Creation time
+    uint64_t created = 0;
+};
+
+/// Registered pools indexed by ID. Entry 0 describes the default pool
+static LLVMPool *jitc_llvm_pools[DRJIT_LLVM_MAX_POOLS] = { };
+
+/// Pool of the current worker thread (\c nullptr: default pool or not a worker)
+static thread_local LLVMPool *jitc_llvm_pool_tls = nullptr;
+
+/// IDs of the pools associated with the priority classes (Normal: 0)
+static uint32_t jitc_priority_pool[3] = { 0, 0, 0 };
+
+/// Size of the default pool before workers were moved to priority pools
+static uint32_t jitc_llvm_default_size = 0;
+
+/// Number of asynchronous releases that haven't taken place yet
+static std::atomic<uint32_t> jitc_llvm_free_async_pending { 0 };
+
+uint64_t jitc_llvm_pool_time() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Statistics of the default pool. Its workers account their work units
+ * without holding the lock, hence this record is never deallocated: a
+ * shutdown merely resets it.
+ */
+static LLVMPool jitc_llvm_pool_default_rec;
+
+static LLVMPool *jitc_llvm_pool_default() {
+    LLVMPool *&p = jitc_llvm_pools[0];
+    if (!p) {
+        p = &jitc_llvm_pool_default_rec;
+        p->created = jitc_llvm_pool_time();
+    }
+    return p;
+}
+
+/// Count the thread states that are bound to the pool 'id'
+static uint32_t jitc_llvm_pool_bound(uint32_t id) {
+    uint32_t count = 0;
+    for (ThreadState *ts : state.tss)
+        count += ts->backend == JitBackend::LLVM && ts->pool_id == id;
+    return count;
+}
+
+static LLVMPool *jitc_llvm_pool_lookup(uint32_t id, const char *func) {
+    LLVMPool *p = id < DRJIT_LLVM_MAX_POOLS ? jitc_llvm_pools[id] : nullptr;
+    if (id == 0)
+        p = jitc_llvm_pool_default();
+    if (!p)
+        jitc_raise("%s(): unknown pool ID %u!", func, id);
+    return p;
+}
+
+/**
+ * Adjust the OS scheduling priority of the calling thread. Runs on worker
+ * threads without holding the lock, hence failures are reported to the
+ * caller instead of being logged here.
+ */
+static bool jitc_llvm_set_thread_priority(JitPriority priority) {
+#if defined(__linux__)
+    if (priority == JitPriority::Low) {
+        sched_param param = {};
+        return pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) == 0;
+    } else if (priority == JitPriority::High) {
+        // Linux supports per-thread nice values via the thread ID
+        return setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), -10) == 0;
+    }
+#else
+    (void) priority;
+#endif
+    return true;
+}
+
+/**
+ * Create a pool and initialize its workers. Every worker must register
+ * itself (and possibly adjust its own scheduling priority), hence a task with
+ * one work unit per worker is submitted. Each unit blocks until all units
+ * have started, which places them on separate workers: a worker that holds a
+ * unit can't pick up another one. The caller waits (without participating in
+ * the task) until every unit has finished.
+ */
+static uint32_t jitc_llvm_pool_create(uint32_t size, JitPriority priority,
+                                      bool user) {
+    if (size == 0)
+        jitc_raise("jit_llvm_pool_create(): the pool must have at least one "
+                   "worker thread!");
+
+    uint32_t id = 1;
+    while (id < DRJIT_LLVM_MAX_POOLS && jitc_llvm_pools[id])
+        id++;
+    if (id == DRJIT_LLVM_MAX_POOLS)
+        jitc_raise("jit_llvm_pool_create(): too many pools!");
+
+    LLVMPool *p = new LLVMPool();
+    p->pool = pool_create(size);
+    p->size = size;
+    p->user = user;
+    p->created = jitc_llvm_pool_time();
+    jitc_llvm_pools[id] = p;
+
+    struct Payload {
+        std::atomic<uint32_t> arrived { 0 }, finished { 0 }, failed { 0 };
+        uint32_t size;
+        JitPriority priority;
+        LLVMPool *pool;
+    };
+
+    Payload payload;
+    payload.size = size;
+    payload.priority = priority;
+    payload.pool = p;
+
+    Task *task = task_submit_dep(
+        p->pool, nullptr, 0, size,
+        [](uint32_t, void *ptr) {
+            Payload *p2 = (Payload *) ptr;
+            if (!jitc_llvm_set_thread_priority(p2->priority))
+                p2->failed++;
+            jitc_llvm_pool_tls = p2->pool;
+            p2->arrived++;
+
+            while (p2->arrived.load() < p2->size)
+                std::this_thread::yield();
+
+            // Last access to the payload, which lives on the caller's stack
+            p2->finished++;
+        },
+        &payload, 0, nullptr, 1);
+
+    task_release(task);
+
+    while (payload.finished.load() < size)
+        std::this_thread::yield();
+
+    uint32_t failed = payload.failed.load();
+    if (failed)
+        jitc_log(Warn,
+                 "jit_llvm_set_priority(): could not change the scheduling "
+                 "priority of %u/%u worker%s (%s), they run with the default "
+                 "priority.", failed, size, size == 1 ? "" : "s",
+                 priority == JitPriority::High
+                     ? "raising the priority requires CAP_SYS_NICE"
+                     : "SCHED_IDLE is not available");
+
+    jitc_log(Info, "jit_llvm_pool_create(): created pool %u with %u worker%s.",
+             id, size, size == 1 ? "" : "s");
+
+    return id;
+}
+
+uint32_t jitc_llvm_pool_create(uint32_t thread_count) {
+    return jitc_llvm_pool_create(thread_count, JitPriority::Normal, true);
+}
+
+void jitc_llvm_pool_destroy(uint32_t id) {
+    LLVMPool *p = jitc_llvm_pool_lookup(id, "jit_llvm_pool_destroy");
+    if (!p->user)
+        jitc_raise("jit_llvm_pool_destroy(): pool %u was not created by "
+                   "jit_llvm_pool_create()!", id);
+    uint32_t bound = jitc_llvm_pool_bound(id);
+    if (bound)
+        jitc_raise("jit_llvm_pool_destroy(): pool %u is still used by %u "
+                   "thread%s!", id, bound, bound == 1 ? "" : "s");
+
+    jitc_llvm_pools[id] = nullptr;
+
+    /* Release the lock while the workers shut down */ {
+        unlock_guard guard(state.lock);
+        pool_destroy(p->pool);
+    }
+
+    delete p;
+}
+
+/// Drain the queue of 'ts' and submit future work to the pool 'id'
+static void jitc_llvm_bind(ThreadState *ts, uint32_t id) {
+    if (ts->pool_id == id)
+        return;
+
+    /* Drain the current queue before switching */ {
+        unlock_guard guard(state.lock);
+        jitc_llvm_sync(ts);
+    }
+
+    LLVMPool *p_new = jitc_llvm_pool_lookup(id, "jit_llvm_set_pool");
+
+    if (!ts->pool && p_new->pool)
+        jitc_llvm_private_queues++;
+    else if (ts->pool && !p_new->pool)
+        jitc_llvm_private_queues--;
+
+    ts->pool = p_new->pool;
+    ts->pool_id = id;
+
+    /* The calling thread helps to process the pool's work units while it
+       waits for them, which should be accounted to the same pool */
+    jitc_llvm_pool_tls = p_new->pool ? p_new : nullptr;
+}
+
+void jitc_llvm_set_pool(uint32_t id) {
+    ThreadState *ts = thread_state(JitBackend::LLVM);
+    jitc_llvm_pool_lookup(id, "jit_llvm_set_pool");
+    jitc_llvm_bind(ts, id);
+    ts->priority = JitPriority::Normal;
+}
+
+uint32_t jitc_llvm_pool() {
+    return thread_state(JitBackend::LLVM)->pool_id;
+}
+
+void jitc_llvm_pool_stats(uint32_t id, LLVMPoolStats *stats) {
+    LLVMPool *p = jitc_llvm_pool_lookup(id, "jit_llvm_pool_stats");
+
+    uint32_t size = p->pool ? p->size : pool_size(nullptr);
+    double busy_time = p->busy_ns.load() * 1e-6,
+           wall_time = (jitc_llvm_pool_time() - p->created) * 1e-6;
+
+    stats->thread_count = size;
+    stats->bound_count = jitc_llvm_pool_bound(id);
+    stats->launches = p->launches;
+    stats->work_units = p->work_units.load();
+    stats->busy_time = busy_time;
+    stats->wall_time = wall_time;
+    stats->utilization =
+        (size && wall_time > 0) ? busy_time / (wall_time * size) : 0.0;
+}
+
+void jitc_llvm_pool_launch(ThreadState *ts) {
+    jitc_llvm_pool_lookup(ts->pool_id, "jit_llvm_pool_launch")->launches++;
+}
+
+void jitc_llvm_pool_account(uint64_t t0) {
+    /* Runs on worker threads without the lock. Pools other than the default
+       pool outlive their workers (see jitc_llvm_pool_destroy()). */
+    LLVMPool *p = jitc_llvm_pool_tls;
+    if (!p)
+        p = &jitc_llvm_pool_default_rec;
+
+    p->work_units++;
+    p->busy_ns += jitc_llvm_pool_time() - t0;
+}
+
+void jitc_llvm_set_priority(JitPriority priority) {
+    if ((uint32_t) priority > (uint32_t) JitPriority::High)
+        jitc_raise("jit_llvm_set_priority(): invalid priority class!");
+
+    ThreadState *ts = thread_state(JitBackend::LLVM);
+    if (ts->priority == priority)
+        return;
+
+    uint32_t id = 0;
+    if (priority != JitPriority::Normal) {
+        uint32_t &id_p = jitc_priority_pool[(int) priority];
+        if (!id_p) {
+            /* Split the cores instead of oversubscribing them: each priority
+               pool receives a quarter of the workers of the default pool,
+               which shrinks accordingly. */
+            uint32_t cores = pool_size(nullptr);
+            if (!jitc_llvm_default_size)
+                jitc_llvm_default_size = cores;
+            uint32_t size = std::max(jitc_llvm_default_size / 4, 1u);
+            id_p = jitc_llvm_pool_create(size, priority, false);
+            if (cores > 1)
+                pool_set_size(nullptr, std::max(cores - size, 1u));
+        }
+        id = id_p;
+    }
+
+    jitc_llvm_bind(ts, id);
+    ts->priority = priority;
+}
+
+JitPriority jitc_llvm_priority() {
+    return thread_state(JitBackend::LLVM)->priority;
+}
+
+void jitc_llvm_cancel(void *token_) {
+    CancelToken *token = (CancelToken *) token_;
+    token->cancel_id.store(token->launch_id.load());
+}
+
+void *jitc_llvm_cancel_token() {
+    return &thread_state(JitBackend::LLVM)->cancel;
+}
+
+void jitc_llvm_set_deadline(float timeout_ms) {
+    uint64_t deadline = 0;
+    if (timeout_ms > 0)
+        deadline = jitc_llvm_pool_time() + (uint64_t) (timeout_ms * 1e6);
+    thread_state(JitBackend::LLVM)->cancel.deadline.store(deadline);
+}
+
+void jitc_llvm_sync(ThreadState *ts) {
+    Task *task;
+    uint32_t eval_id;
+
+    /* Don't detach the head: other threads may still append to the queue */ {
+        lock_guard guard(state.lock);
+        task = jitc_task_head(ts);
+        if (!task)
+            return;
+        task_retain(task);
+        eval_id = jitc_event_last_eval();
+    }
+
+    task_wait(task);
+
+    lock_guard guard(state.lock);
+    Task *&head = jitc_task_head(ts);
+    jitc_event_synced(&head, eval_id);
+    if (head == task) {
+        task_release(head);
+        head = nullptr;
+    }
+    task_release(task);
+}
+
+void jitc_llvm_defer(void (*func)(void *), const void *payload,
+                     size_t payload_size) {
+    std::vector<Task *> deps;
+    if (jitc_task)
+        deps.push_back(jitc_task);
+
+    for (ThreadState *ts : state.tss) {
+        if (ts->backend == JitBackend::LLVM && ts->task)
+            deps.push_back(ts->task);
+    }
+
+    if (deps.empty()) {
+        func((void *) payload);
+        return;
+    }
+
+    struct DeferRecord {
+        void (*func)(void *);
+        uint8_t payload[1];
+    };
+
+    size_t record_size = offsetof(DeferRecord, payload) + payload_size;
+    std::unique_ptr<uint8_t[]> record(new uint8_t[record_size]);
+    DeferRecord *r = (DeferRecord *) record.get();
+    r->func = func;
+    memcpy(r->payload, payload, payload_size);
+    jitc_llvm_free_async_pending++;
+
+    Task *task = task_submit_dep(
+        nullptr, deps.data(), (uint32_t) deps.size(), 1,
+        [](uint32_t, void *payload_) {
+            DeferRecord *r2 = (DeferRecord *) payload_;
+            r2->func(r2->payload);
+            jitc_llvm_free_async_pending--;
+        },
+        r, (uint32_t) record_size, nullptr, 1);
+
+    task_release(task);
+}
+
+void jitc_llvm_free_async(uint64_t info, void *ptr) {
+    struct ReleaseRecord {
+        AllocInfo info;
+        void *ptr;
+    };
+
+    ReleaseRecord r { info, ptr };
+    jitc_llvm_defer(
+        [](void *payload) {
+            ReleaseRecord *r2 = (ReleaseRecord *) payload;
+            jitc_cow_release(r2->ptr);
+            lock_guard guard(state.alloc_free_lock);
+            state.alloc_free[r2->info].push_back(r2->ptr);
+        },
+        &r, sizeof(ReleaseRecord));
+}
+
+void jitc_llvm_free_async_wait() {
+    while (jitc_llvm_free_async_pending.load() != 0)
+        std::this_thread::yield();
+}
+
+void jitc_llvm_pool_shutdown() {
+    jitc_llvm_free_async_wait();
+
+    for (uint32_t i = 1; i < DRJIT_LLVM_MAX_POOLS; ++i) {
+        LLVMPool *p = jitc_llvm_pools[i];
+        if (!p)
+            continue;
+        if (p->user)
+            jitc_log(Warn, "jit_shutdown(): leaked LLVM thread pool %u.", i);
+        pool_destroy(p->pool);
+        delete p;
+        jitc_llvm_pools[i] = nullptr;
+    }
+
+    LLVMPool &p0 = jitc_llvm_pool_default_rec;
+    p0.launches = 0;
+    p0.work_units = 0;
+    p0.busy_ns = 0;
+    jitc_llvm_pools[0] = nullptr;
+
+    for (uint32_t &id : jitc_priority_pool)
+        id = 0;
+
+    // Return the workers of the priority pools to the default pool
+    if (jitc_llvm_default_size) {
+        pool_set_size(nullptr, jitc_llvm_default_size);
+        jitc_llvm_default_size = 0;
+    }
+    jitc_llvm_private_queues = 0;
+}
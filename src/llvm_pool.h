@@ -0,0 +1,113 @@
+/*
+    src/llvm_pool.h -- Thread pools and task queues of the LLVM backend
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include "internal.h"
+#include "llvm.h"
+
+/**
+ * \brief Return the head of the task queue that receives LLVM work submitted
+ * by the given thread state
+ *
+ * Thread states using the shared default pool append to the global queue
+ * \ref jitc_task. Thread states that were moved to another pool (e.g. via
+ * \ref jitc_llvm_set_priority()) have a private queue, which allows their
+ * work to proceed independently of everything else.
+ */
+inline Task *&jitc_task_head(ThreadState *ts) {
+    return ts->pool ? ts->task : jitc_task;
+}
+
+/// Number of thread states with a private task queue
+extern uint32_t jitc_llvm_private_queues;
+
+/// Maximum number of LLVM thread pools, including the default pool
+#define DRJIT_LLVM_MAX_POOLS 64
+
+/// Create a new pool and return its ID
+extern uint32_t jitc_llvm_pool_create(uint32_t thread_count);
+
+/// Destroy a pool created by \ref jitc_llvm_pool_create()
+extern void jitc_llvm_pool_destroy(uint32_t id);
+
+/// Bind the calling thread to a pool
+extern void jitc_llvm_set_pool(uint32_t id);
+
+/// Return the ID of the pool used by the calling thread
+extern uint32_t jitc_llvm_pool();
+
+/// Query utilization statistics of a pool
+extern void jitc_llvm_pool_stats(uint32_t id, LLVMPoolStats *stats);
+
+/// Record a kernel launch into the pool used by 'ts'
+extern void jitc_llvm_pool_launch(ThreadState *ts);
+
+/// Return a timestamp (in nanoseconds) for \ref jitc_llvm_pool_account()
+extern uint64_t jitc_llvm_pool_time();
+
+/// Account a work unit that started at time 't0' to the pool of the caller
+extern void jitc_llvm_pool_account(uint64_t t0);
+
+/// Should a work unit of the launch 'launch_id' be skipped?
+inline bool jitc_llvm_cancelled(CancelToken *token, uint64_t launch_id) {
+    uint64_t deadline = token->deadline.load(std::memory_order_relaxed);
+    if (likely(token->cancel_id.load(std::memory_order_relaxed) < launch_id &&
+               (deadline == 0 || jitc_llvm_pool_time() < deadline)))
+        return false;
+
+    token->cancelled.store(1, std::memory_order_relaxed);
+    return true;
+}
+
+/// Cancel all kernels launched so far by the owner of 'token'
+extern void jitc_llvm_cancel(void *token);
+
+/// Return the cancellation token of the calling thread
+extern void *jitc_llvm_cancel_token();
+
+/// Set a deadline for kernels launched by the calling thread (0: disable)
+extern void jitc_llvm_set_deadline(float timeout_ms);
+
+/// Change the priority class of LLVM work submitted by the calling thread
+extern void jitc_llvm_set_priority(JitPriority priority);
+
+/// Return the priority class of LLVM work submitted by the calling thread
+extern JitPriority jitc_llvm_priority();
+
+/// Wait for the task queue of the given thread state (called without lock)
+extern void jitc_llvm_sync(ThreadState *ts);
+
+/**
+ * \brief Run <tt>func(payload)</tt> once all task queues have reached their
+ * current position
+ *
+ * The payload is copied. If no work is pending, the function runs immediately
+ * on the calling thread. \ref jitc_llvm_free_async_wait() also waits for
+ * pending invocations.
+ */
+extern void jitc_llvm_defer(void (*func)(void *), const void *payload,
+                            size_t payload_size);
+
+/**
+ * \brief Release a host-asynchronous allocation once all task queues have
+ * caught up
+ *
+ * When private task queues exist, the memory could still be accessed by work
+ * in any queue, and another queue could pick it up from the allocation cache
+ * without being ordered after that work. The memory is therefore only returned
+ * to the allocation cache once every queue has reached the current position.
+ */
+extern void jitc_llvm_free_async(uint64_t info, void *ptr);
+
+/// Wait until all asynchronous releases have taken place (called without lock)
+extern void jitc_llvm_free_async_wait();
+
+/// Release all pools created by this module
+extern void jitc_llvm_pool_shutdown();
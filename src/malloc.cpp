@@ -11,11 +11,18 @@
 #include "log.h"
 #include "util.h"
 #include "profiler.h"
+#include "numa.h"
+#include "llvm_pool.h"
+#include "cow.h"
 
 #if !defined(_WIN32)
 #  include <sys/mman.h>
 #endif
 
+#if defined(__linux__)
+#  include <unistd.h>
+#endif
+
 // Try to use huge pages for allocations > 2M (only on Linux)
 #if defined(__linux__)
 #  define DRJIT_HUGEPAGE 1
@@ -25,6 +32,18 @@
 
 #define DRJIT_HUGEPAGE_SIZE (2 * 1024 * 1024)
 
+#if defined(__linux__)
+/// Shareable allocation created by \ref jitc_malloc_shared()
+struct SharedAlloc {
+    void *ptr;
+    size_t size;
+    int fd;
+};
+
+/// Map from the address of a shareable allocation to its record (protected by 'state.lock')
+static tsl::robin_map<uintptr_t, SharedAlloc, UInt64Hasher> jitc_shared_allocs;
+#endif
+
 static_assert(
     sizeof(tsl::detail_robin_hash::bucket_entry<AllocUsedMap::value_type, false>) == 24,
     "AllocUsedMap: incorrect bucket size, likely an issue with padding/packing!");
@@ -109,6 +128,8 @@ void* jitc_malloc(AllocType type, size_t size) {
     if (size == 0)
         return nullptr;
 
+    size_t size_req = size;
+
     if ((type != AllocType::Host && type != AllocType::HostAsync) ||
         jitc_llvm_vector_width < 16) {
         // Round up to the next multiple of 64 bytes
@@ -160,6 +181,13 @@ void* jitc_malloc(AllocType type, size_t size) {
             /* Temporarily release the main lock */ {
                 if (backend != JitBackend::CUDA) {
                     ptr = aligned_malloc(size);
+
+                    /* Place the pages of large mappings on the NUMA nodes
+                       that will process the associated work units */
+                    if (ptr && type == AllocType::HostAsync &&
+                        size >= DRJIT_HUGEPAGE_SIZE &&
+                        jit_flag(JitFlag::NumaAffinity))
+                        jitc_numa_first_touch(ptr, size_req);
                 } else {
                     scoped_set_context guard_2(ts->context);
                     CUresult ret;
@@ -220,7 +248,37 @@ void jitc_free(void *ptr) {
     auto [size, type, device] = alloc_info_decode(info);
     state.alloc_usage[(int) type] -= size;
 
-    if (type != AllocType::HostPinned) {
+#if defined(__linux__)
+    if (unlikely(!jitc_shared_allocs.empty())) {
+        auto it2 = jitc_shared_allocs.find((uintptr_t) ptr);
+        if (it2 != jitc_shared_allocs.end()) {
+            /* Shareable memory is never recycled, since other processes may
+               still map the file. Unmap it once queued kernels have finished. */
+            SharedAlloc sa = it2->second;
+            jitc_shared_allocs.erase(it2);
+            state.alloc_allocated[(int) type] -= size;
+
+            jitc_llvm_defer(
+                [](void *payload) {
+                    SharedAlloc *sa2 = (SharedAlloc *) payload;
+                    munmap(sa2->ptr, sa2->size);
+                    close(sa2->fd);
+                },
+                &sa, sizeof(SharedAlloc));
+
+            jitc_trace("jit_free(" DRJIT_PTR ", type=shared, size=%zu)",
+                       (uintptr_t) ptr, size);
+            return;
+        }
+    }
+#endif
+
+    if (type == AllocType::HostAsync &&
+        (jitc_llvm_private_queues || jitc_cow_mapped(ptr))) {
+        /* Multiple task queues (see llvm_pool.h), or a copy-on-write mapping
+           that must be reset once it is no longer used (see cow.h) */
+        jitc_llvm_free_async(info, ptr);
+    } else if (type != AllocType::HostPinned) {
         lock_guard guard(state.alloc_free_lock);
         state.alloc_free[info].push_back(ptr);
     } else {
@@ -255,11 +313,67 @@ void jitc_free(void *ptr) {
                    (uintptr_t) ptr, alloc_type_name[(int) type], size);
 }
 
+#if defined(__linux__)
+void *jitc_malloc_shared(size_t size, int *fd_out) {
+    if (size == 0)
+        return nullptr;
+
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    size = (size + page_size - 1) / page_size * page_size;
+
+    void *ptr = MAP_FAILED;
+    int fd = memfd_create("drjit-shared", MFD_CLOEXEC);
+    if (fd >= 0 && ftruncate(fd, (off_t) size) == 0)
+        ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (unlikely(ptr == MAP_FAILED)) {
+        int errno_saved = errno;
+        if (fd >= 0)
+            close(fd);
+        jitc_raise("jit_malloc_shared(): could not allocate %zu bytes of "
+                   "shareable memory: %s", size, strerror(errno_saved));
+    }
+
+    AllocType type = AllocType::HostAsync;
+    size_t &allocated = state.alloc_allocated[(int) type],
+           &watermark = state.alloc_watermark[(int) type];
+    allocated += size;
+    watermark = std::max(allocated, watermark);
+
+    state.alloc_used.emplace((uintptr_t) ptr, alloc_info_encode(size, type, 0));
+    state.alloc_usage[(int) type] += size;
+    jitc_shared_allocs[(uintptr_t) ptr] = SharedAlloc{ ptr, size, fd };
+
+    jitc_trace("jit_malloc_shared(size=%zu): " DRJIT_PTR " (fd=%i)", size,
+               (uintptr_t) ptr, fd);
+
+    *fd_out = fd;
+    return ptr;
+}
+
+int jitc_malloc_shared_fd(const void *ptr) {
+    auto it = jitc_shared_allocs.find((uintptr_t) ptr);
+    return it != jitc_shared_allocs.end() ? it->second.fd : -1;
+}
+#else
+void *jitc_malloc_shared(size_t, int *) {
+    jitc_raise("jit_malloc_shared(): only supported on Linux!");
+}
+
+int jitc_malloc_shared_fd(const void *) { return -1; }
+#endif
+
 void jitc_malloc_clear_statistics() {
     for (int i = 0; i < (int) AllocType::Count; ++i)
         state.alloc_watermark[i] = state.alloc_allocated[i];
 }
 
+size_t jitc_malloc_watermark(AllocType type) {
+    if (unlikely((int) type < 0 || type >= AllocType::Count))
+        jitc_raise("jit_malloc_watermark(): invalid allocation type!");
+    return state.alloc_watermark[(int) type];
+}
+
 void* jitc_malloc_migrate(void *ptr, AllocType dst_type, int move) {
     if (!ptr)
         return nullptr;
@@ -294,6 +408,18 @@ void* jitc_malloc_migrate(void *ptr, AllocType dst_type, int move) {
     if ((src_type == AllocType::Host && dst_type == AllocType::HostAsync) ||
         (src_type == AllocType::HostAsync && dst_type == AllocType::Host)) {
         if (move) {
+            if (src_type == AllocType::HostAsync && jitc_cow_mapped(ptr)) {
+                /* Copy-on-write state is only maintained for host-asynchronous
+                   memory (see cow.h). Wait for pending copies that involve
+                   the region, then stop tracking it. */
+                jitc_sync_thread();
+                if (jitc_cow_forget(ptr))
+                    jitc_trace("jit_malloc_migrate(" DRJIT_PTR "): no longer "
+                               "tracking copy-on-write mapping",
+                               (uintptr_t) ptr);
+                it = state.alloc_used.find((uintptr_t) ptr);
+            }
+
             state.alloc_usage[(int) src_type] -= size;
             state.alloc_usage[(int) dst_type] += size;
             state.alloc_allocated[(int) src_type] -= size;
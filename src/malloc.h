@@ -43,6 +43,21 @@ extern void *jitc_malloc(AllocType type, size_t size) JIT_MALLOC;
 /// Release the given pointer
 extern void jitc_free(void *ptr);
 
+/**
+ * \brief Allocate host memory whose backing store can be shared with other
+ * processes
+ *
+ * The region is a \c MAP_SHARED mapping of an in-memory file created via \c
+ * memfd_create(), whose descriptor is written to \c fd. It otherwise behaves
+ * like a \ref AllocType::HostAsync allocation and is released via \ref
+ * jitc_free(), which closes the descriptor. Such allocations are never
+ * recycled by the allocation cache. Only supported on Linux.
+ */
+extern void *jitc_malloc_shared(size_t size, int *fd);
+
+/// Return the file descriptor of a shareable allocation, or -1 if 'ptr' is not one
+extern int jitc_malloc_shared_fd(const void *ptr);
+
 /// Change the flavor of an allocated memory region
 extern void* jitc_malloc_migrate(void *ptr, AllocType type, int move);
 
@@ -60,3 +75,6 @@ extern int jitc_malloc_device(void *ptr);
 
 /// Clear the peak memory usage statistics
 extern void jitc_malloc_clear_statistics();
+
+/// Return the peak amount of memory of the given type held by the allocator
+extern size_t jitc_malloc_watermark(AllocType type);
@@ -0,0 +1,255 @@
+/*
+    src/mmap.cpp -- Variables that directly reference memory-mapped files
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "mmap.h"
+#include "var.h"
+#include "log.h"
+#include "llvm_pool.h"
+#include "malloc.h"
+#include "util.h"
+
+#if !defined(_WIN32)
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+
+/// A memory-mapped file region referenced by an LLVM variable
+struct MappedRegion {
+    /// Page-aligned start address and size of the mapping
+    void *base;
+    size_t size;
+
+    /// Access hint requested by the user
+    MemAdvice advice;
+
+    /// Has a gather switched the region to random access?
+    bool random;
+};
+
+/// Map from the data pointer of a variable to its mapping (protected by 'state.lock')
+static tsl::robin_map<uintptr_t, MappedRegion, UInt64Hasher> jitc_mmap_regions;
+
+static void jitc_mmap_advise(void *base, size_t size, MemAdvice advice) {
+    int value;
+    switch (advice) {
+        case MemAdvice::Sequential: value = MADV_SEQUENTIAL; break;
+        case MemAdvice::Random:     value = MADV_RANDOM;     break;
+        case MemAdvice::WillNeed:   value = MADV_WILLNEED;   break;
+        default:                    value = MADV_NORMAL;     break;
+    }
+
+    if (madvise(base, size, value) != 0)
+        jitc_log(Debug, "jit_var_mem_map_file(): madvise() failed: %s",
+                 strerror(errno));
+}
+
+/// Free callback: unmap the region once queued kernels no longer access it
+static void jitc_mmap_free(uint32_t index, int free_var, void *ptr) {
+    if (!free_var)
+        return;
+
+    auto it = jitc_mmap_regions.find((uintptr_t) ptr);
+    if (it == jitc_mmap_regions.end())
+        jitc_fail("jit_var_mem_map_file(): mapping of r%u not found!", index);
+
+    MappedRegion region = it->second;
+    jitc_mmap_regions.erase(it);
+
+    jitc_log(Debug, "jit_var_mem_map_file(): unmapping r%u (" DRJIT_PTR ")",
+             index, (uintptr_t) region.base);
+
+    jitc_llvm_defer(
+        [](void *payload) {
+            MappedRegion *r = (MappedRegion *) payload;
+            munmap(r->base, r->size);
+        },
+        &region, sizeof(MappedRegion));
+}
+
+/**
+ * Map 'count' elements starting at byte 'offset' of the file 'fd' and create
+ * a variable from it. 'name' describes the file in messages of the API
+ * function 'func'. Does not take ownership of 'fd'.
+ */
+static uint32_t jitc_mmap_create(const char *func, JitBackend backend, int fd,
+                                 const char *name, size_t offset,
+                                 VarType type, size_t count,
+                                 MemAdvice advice) {
+    uint32_t tsize = type_size[(int) type];
+    if (unlikely(tsize == 0 || type == VarType::Pointer))
+        jitc_raise("%s(): unsupported variable type!", func);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+        jitc_raise("%s(): could not query the size of %s: %s", func, name,
+                   strerror(errno));
+
+    size_t file_size = (size_t) st.st_size;
+    if (count == 0 && offset < file_size)
+        count = (file_size - offset) / tsize;
+
+    if (unlikely(count == 0 || offset > file_size ||
+                 count > (file_size - offset) / tsize))
+        jitc_raise("%s(): the region [%zu, %zu) is empty or exceeds the size "
+                   "of %s (%zu bytes)!", func, offset, offset + count * tsize,
+                   name, file_size);
+
+    if (unlikely(count > 0xFFFFFFFF))
+        jitc_raise("%s(): tried to create an array with %zu entries, which "
+                   "exceeds the limit of 2^32 == 4294967296 entries.", func,
+                   count);
+
+    // mmap() requires a page-aligned file offset
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE),
+           map_offset = offset / page_size * page_size,
+           map_size = offset - map_offset + count * tsize;
+
+    /* Pages that are written to (e.g. by an in-place scatter) become private
+       copies, hence the file itself is never modified */
+    void *base = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                      fd, (off_t) map_offset);
+
+    if (base == MAP_FAILED)
+        jitc_raise("%s(): mmap() of %s failed: %s", func, name,
+                   strerror(errno));
+
+    void *ptr = (uint8_t *) base + (offset - map_offset);
+
+    if (backend == JitBackend::CUDA) {
+        // The data must be uploaded anyways, which reads it front to back
+        jitc_mmap_advise(base, map_size, MemAdvice::Sequential);
+
+        uint32_t index;
+        try {
+            index = jitc_var_mem_copy(backend, AllocType::Host, type, ptr, count);
+        } catch (...) {
+            munmap(base, map_size);
+            throw;
+        }
+        munmap(base, map_size);
+
+        jitc_log(Debug, "%s(%s r%u[%zu] <- %s @ %zu): uploaded", func,
+                 type_name[(int) type], index, count, name, offset);
+        return index;
+    }
+
+    jitc_mmap_advise(base, map_size, advice);
+
+    uint32_t index = jitc_var_mem_map(backend, type, ptr, count, 0);
+    jitc_mmap_regions[(uintptr_t) ptr] =
+        MappedRegion{ base, map_size, advice, false };
+
+    Extra &extra = state.extra[index];
+    extra.callback = jitc_mmap_free;
+    extra.callback_data = ptr;
+    extra.callback_internal = true;
+    jitc_var(index)->extra = true;
+
+    jitc_log(Debug, "%s(%s r%u[%zu] <- %s @ %zu): " DRJIT_PTR, func,
+             type_name[(int) type], index, count, name, offset,
+             (uintptr_t) ptr);
+
+    return index;
+}
+
+uint32_t jitc_var_mem_map_file(JitBackend backend, const char *path,
+                               size_t offset, VarType type, size_t count,
+                               MemAdvice advice) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        jitc_raise("jit_var_mem_map_file(): could not open \"%s\": %s", path,
+                   strerror(errno));
+
+    std::string name = std::string("\"") + path + "\"";
+
+    uint32_t index;
+    try {
+        index = jitc_mmap_create("jit_var_mem_map_file", backend, fd,
+                                 name.c_str(), offset, type, count, advice);
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+    return index;
+}
+
+uint32_t jitc_var_import_fd(JitBackend backend, int fd, VarType type,
+                            size_t count) {
+    char name[32];
+    snprintf(name, sizeof(name), "file descriptor %i", fd);
+    return jitc_mmap_create("jit_var_import_fd", backend, fd, name, 0, type,
+                            count, MemAdvice::Auto);
+}
+
+uint32_t jitc_var_export_fd(uint32_t index, int *fd_out) {
+    const Variable *v = jitc_var(index);
+    if (unlikely((JitBackend) v->backend != JitBackend::LLVM))
+        jitc_raise("jit_var_export_fd(): r%u is not a host (LLVM) array!",
+                   index);
+
+    void *src = jitc_var_ptr(index); // evaluate, even if it is a literal
+    int fd = jitc_malloc_shared_fd(src);
+    if (fd >= 0) {
+        *fd_out = fd;
+        jitc_var_inc_ref(index);
+        return index;
+    }
+
+    /* Copy into a new variable backed by a shareable allocation. The memory
+       of 'index' can't be swapped out, since kernels may reference it via
+       pointer literals (e.g. jit_var_data(), jit_var_mem_map()). */
+    v = jitc_var(index);
+    VarType type = (VarType) v->type;
+    uint32_t count = v->size;
+    size_t size = (size_t) count * (size_t) type_size[(int) type];
+    void *dst = jitc_malloc_shared(size, &fd);
+    jitc_memcpy(JitBackend::LLVM, dst, src, size);
+
+    uint32_t result = jitc_var_mem_map(JitBackend::LLVM, type, dst, count, 1);
+    *fd_out = fd;
+
+    jitc_log(Debug, "jit_var_export_fd(r%u <- r%u): %zu bytes, fd=%i", result,
+             index, size, fd);
+
+    return result;
+}
+
+void jitc_mmap_gather(const void *ptr) {
+    if (likely(jitc_mmap_regions.empty()))
+        return;
+
+    auto it = jitc_mmap_regions.find((uintptr_t) ptr);
+    if (it == jitc_mmap_regions.end())
+        return;
+
+    MappedRegion &region = it.value();
+    if (region.advice != MemAdvice::Auto || region.random)
+        return;
+
+    jitc_mmap_advise(region.base, region.size, MemAdvice::Random);
+    region.random = true;
+}
+#else
+uint32_t jitc_var_mem_map_file(JitBackend, const char *, size_t, VarType,
+                               size_t, MemAdvice) {
+    jitc_raise("jit_var_mem_map_file(): not supported on Windows!");
+}
+
+uint32_t jitc_var_import_fd(JitBackend, int, VarType, size_t) {
+    jitc_raise("jit_var_import_fd(): not supported on Windows!");
+}
+
+uint32_t jitc_var_export_fd(uint32_t, int *) {
+    jitc_raise("jit_var_export_fd(): not supported on Windows!");
+}
+
+void jitc_mmap_gather(const void *) { }
+#endif
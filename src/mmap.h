@@ -0,0 +1,33 @@
+/*
+    src/mmap.h -- Variables that directly reference memory-mapped files
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include "internal.h"
+
+/// Map a region of a file into memory and create a variable from it (see jit.h)
+extern uint32_t jitc_var_mem_map_file(JitBackend backend, const char *path,
+                                      size_t offset, VarType type,
+                                      size_t count, MemAdvice advice);
+
+/**
+ * \brief Notify this module that a gather operation reads from 'ptr'
+ *
+ * Switches the access hint of a memory-mapped file with advice \c
+ * MemAdvice::Auto to random access, since read-ahead would then mostly fetch
+ * pages that are never used.
+ */
+extern void jitc_mmap_gather(const void *ptr);
+
+/// Create a variable that maps the contents of a shared file descriptor (see jit.h)
+extern uint32_t jitc_var_import_fd(JitBackend backend, int fd, VarType type,
+                                   size_t count);
+
+/// Return a copy of a host array in shareable memory and its descriptor (see jit.h)
+extern uint32_t jitc_var_export_fd(uint32_t index, int *fd);
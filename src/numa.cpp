@@ -0,0 +1,202 @@
+/*
+    src/numa.cpp -- NUMA topology detection, worker affinity, and
+    node-aware scheduling of work units for the LLVM backend
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "numa.h"
+#include "internal.h"
+#include "log.h"
+
+#if defined(__linux__)
+#  include <sched.h>
+#  include <pthread.h>
+#endif
+
+/// Granularity of the parallel first-touch pass
+static constexpr size_t jitc_numa_chunk_size = 2 * 1024 * 1024;
+
+/// Number of NUMA nodes with at least one CPU
+static uint32_t jitc_numa_nodes = 1;
+
+#if defined(__linux__)
+/// CPUs associated with each NUMA node
+static cpu_set_t jitc_numa_cpus[DRJIT_NUMA_MAX_NODES];
+
+/// Map from CPU index to NUMA node
+static std::vector<uint8_t> jitc_numa_cpu_node;
+
+/// Node that the current thread has been pinned to (or -1)
+static thread_local int jitc_numa_thread_node = -1;
+
+/// Parse a CPU list of the form "0-15,32-47"
+static bool jitc_numa_parse_cpulist(const char *fname, cpu_set_t &set) {
+    FILE *f = fopen(fname, "r");
+    if (!f)
+        return false;
+
+    CPU_ZERO(&set);
+    bool found = false;
+    unsigned int a, b;
+    while (fscanf(f, "%u", &a) == 1) {
+        b = a;
+        int c = fgetc(f);
+        if (c == '-') {
+            if (fscanf(f, "%u", &b) != 1)
+                break;
+            c = fgetc(f);
+        }
+        for (unsigned int i = a; i <= b && i < CPU_SETSIZE; ++i) {
+            CPU_SET(i, &set);
+            found = true;
+        }
+        if (c != ',')
+            break;
+    }
+
+    fclose(f);
+    return found;
+}
+#endif
+
+void jitc_numa_init() {
+    jitc_numa_nodes = 1;
+
+#if defined(__linux__)
+    jitc_numa_cpu_node.clear();
+    uint32_t nodes = 0;
+
+    for (uint32_t i = 0; i < 1024 && nodes < DRJIT_NUMA_MAX_NODES; ++i) {
+        char fname[128];
+        snprintf(fname, sizeof(fname),
+                 "/sys/devices/system/node/node%u/cpulist", i);
+
+        // Skip nonexistent and memory-only nodes
+        if (!jitc_numa_parse_cpulist(fname, jitc_numa_cpus[nodes]))
+            continue;
+
+        for (uint32_t j = 0; j < CPU_SETSIZE; ++j) {
+            if (!CPU_ISSET(j, &jitc_numa_cpus[nodes]))
+                continue;
+            if (j >= jitc_numa_cpu_node.size())
+                jitc_numa_cpu_node.resize(j + 1, 0);
+            jitc_numa_cpu_node[j] = (uint8_t) nodes;
+        }
+
+        nodes++;
+    }
+
+    if (nodes > 1) {
+        jitc_numa_nodes = nodes;
+        jitc_log(Info, "jit_init(): detected %u NUMA nodes.", nodes);
+    }
+#endif
+}
+
+uint32_t jitc_numa_node_count() { return jitc_numa_nodes; }
+
+uint32_t jitc_numa_pin_thread() {
+#if defined(__linux__)
+    if (jitc_numa_nodes == 1)
+        return 0;
+
+    if (likely(jitc_numa_thread_node >= 0))
+        return (uint32_t) jitc_numa_thread_node;
+
+    uint32_t id = pool_thread_id();
+    if (id == 0) {
+        // Not a worker thread: don't change its affinity
+        int cpu = sched_getcpu();
+        if (cpu < 0 || (size_t) cpu >= jitc_numa_cpu_node.size())
+            return 0;
+        return jitc_numa_cpu_node[cpu];
+    }
+
+    uint32_t node = (id - 1) % jitc_numa_nodes;
+    int rv = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                                    &jitc_numa_cpus[node]);
+    if (rv != 0)
+        jitc_log(Warn, "jit_numa_pin_thread(): pthread_setaffinity_np() "
+                       "failed (%i).", rv);
+
+    jitc_numa_thread_node = (int) node;
+    return node;
+#else
+    return 0;
+#endif
+}
+
+NumaSchedule *jitc_numa_schedule_new(uint32_t blocks, size_t payload_size) {
+    NumaSchedule *s =
+        (NumaSchedule *) malloc_check(sizeof(NumaSchedule) + payload_size);
+    uint32_t nodes = jitc_numa_nodes;
+    s->node_count = nodes;
+
+    for (uint32_t i = 0; i < nodes; ++i) {
+        // Node 'i' owns the blocks 'j' with j * nodes / blocks == i
+        uint32_t start = (uint32_t) (((uint64_t) i * blocks + nodes - 1) / nodes),
+                 end   = (uint32_t) (((uint64_t) (i + 1) * blocks + nodes - 1) / nodes);
+        new (&s->next[i]) std::atomic<uint32_t>(start);
+        s->end[i] = end;
+    }
+
+    return s;
+}
+
+void jitc_numa_schedule_free(void *schedule) {
+    free(schedule);
+}
+
+uint32_t jitc_numa_schedule_claim(NumaSchedule *s) {
+    uint32_t node = jitc_numa_pin_thread(),
+             nodes = s->node_count;
+
+    // Process local work first, then steal from the other nodes
+    for (uint32_t i = 0; i < nodes; ++i) {
+        uint32_t n = (node + i) % nodes;
+        if (s->next[n].load(std::memory_order_relaxed) >= s->end[n])
+            continue;
+
+        uint32_t index = s->next[n].fetch_add(1, std::memory_order_relaxed);
+        if (index < s->end[n])
+            return index;
+    }
+
+    jitc_fail("jit_numa_schedule_claim(): internal error, ran out of work units!");
+}
+
+void jitc_numa_first_touch(void *ptr, size_t size) {
+    uint32_t blocks = (uint32_t) ((size + jitc_numa_chunk_size - 1) /
+                                  jitc_numa_chunk_size);
+    if (blocks < 2 || jitc_numa_nodes == 1)
+        return;
+
+    struct Payload {
+        uint8_t *ptr;
+        size_t size;
+    };
+
+    NumaSchedule *s = jitc_numa_schedule_new(blocks, sizeof(Payload));
+    *((Payload *) s->payload()) = Payload{ (uint8_t *) ptr, size };
+
+    Task *task = task_submit_dep(
+        nullptr, nullptr, 0, blocks,
+        [](uint32_t, void *payload) {
+            NumaSchedule *s2 = (NumaSchedule *) payload;
+            const Payload &p = *((Payload *) s2->payload());
+            size_t start = (size_t) jitc_numa_schedule_claim(s2) *
+                           jitc_numa_chunk_size,
+                   end   = std::min(start + jitc_numa_chunk_size, p.size);
+
+            // Fresh anonymous mappings are zero-filled, writing zero is harmless
+            for (size_t i = start; i < end; i += 4096)
+                ((volatile uint8_t *) p.ptr)[i] = 0;
+        },
+        s, 0, jitc_numa_schedule_free);
+
+    task_wait_and_release(task);
+}
@@ -0,0 +1,70 @@
+/*
+    src/numa.h -- NUMA topology detection, worker affinity, and
+    node-aware scheduling of work units for the LLVM backend
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+/// Maximum number of NUMA nodes that are taken into account
+#define DRJIT_NUMA_MAX_NODES 16
+
+/**
+ * \brief Assignment of a parallel task's work units to NUMA nodes
+ *
+ * Work unit ``i`` of ``blocks`` is associated with node ``i * nodes /
+ * blocks``, i.e., every node owns a contiguous range of work units. Since
+ * nanothread hands out work units in arbitrary order, the callback of a task
+ * using this data structure ignores the index it was given and instead claims
+ * a block from the range owned by the node of the executing thread. Once that
+ * range is exhausted, it steals from the other nodes. The number of claims
+ * matches the number of work units, hence every claim succeeds.
+ */
+struct NumaSchedule {
+    uint32_t node_count;
+    uint32_t end[DRJIT_NUMA_MAX_NODES];
+    std::atomic<uint32_t> next[DRJIT_NUMA_MAX_NODES];
+
+    /// Payload that follows the schedule in memory (kernel parameters, etc.)
+    void *payload() { return (void *) (this + 1); }
+};
+
+/// Detect the NUMA topology of the machine (only on Linux)
+extern void jitc_numa_init();
+
+/// Return the number of NUMA nodes with at least one CPU (1 if unknown)
+extern uint32_t jitc_numa_node_count();
+
+/**
+ * \brief Pin the calling nanothread worker to the CPUs of a NUMA node and
+ * return the node index. Workers are assigned to nodes in a round-robin
+ * fashion. Threads outside of the pool are not pinned, in which case the
+ * function returns the node of the CPU they currently run on.
+ */
+extern uint32_t jitc_numa_pin_thread();
+
+/// Create a schedule for 'blocks' work units followed by 'payload_size' bytes
+extern NumaSchedule *jitc_numa_schedule_new(uint32_t blocks,
+                                            size_t payload_size);
+
+/// Release a schedule created by \ref jitc_numa_schedule_new()
+extern void jitc_numa_schedule_free(void *schedule);
+
+/// Claim the next work unit for the calling thread
+extern uint32_t jitc_numa_schedule_claim(NumaSchedule *schedule);
+
+/**
+ * \brief Touch the pages of a freshly mapped host memory region in parallel
+ * so that the OS places every part on the node whose workers will later
+ * process the corresponding work units. Only the first ``size`` bytes are
+ * considered.
+ */
+extern void jitc_numa_first_touch(void *ptr, size_t size);
@@ -4,6 +4,7 @@
 #include "log.h"
 #include "eval.h"
 #include "op.h"
+#include "mmap.h"
 
 template <bool Value> using enable_if_t = std::enable_if_t<Value, int>;
 
@@ -240,6 +241,7 @@ JIT_INLINE uint32_t jitc_eval_literal(const VarInfo &info, Func func,
         case VarType::UInt64:  r = v2i(func(i2v<uint64_t>(args->literal)...)); break;
         case VarType::Float32: r = v2i(func(i2v<   float>(args->literal)...)); break;
         case VarType::Float64: r = v2i(func(i2v<  double>(args->literal)...)); break;
+        case VarType::Float16: return 0; // not folded, the caller creates a node
         default: jitc_fail("jit_eval_literal(): unsupported variable type!");
     }
 
@@ -1193,11 +1195,13 @@ uint32_t jitc_var_rcp(uint32_t a0) {
         result = jitc_eval_literal(info, [](auto l0) { return eval_rcp(l0); }, v0);
 
     if (!result && info.backend == JitBackend::LLVM) {
-        float f1 = 1.f; double d1 = 1.0;
-        uint32_t one = jitc_var_literal(info.backend, info.type,
-                                            info.type == VarType::Float32
-                                                ? (const void *) &f1
-                                                : (const void *) &d1, 1, 0);
+        float f1 = 1.f; double d1 = 1.0; uint16_t h1 = 0x3c00;
+        const void *one_ptr = &d1;
+        if (info.type == VarType::Float32)
+            one_ptr = &f1;
+        else if (info.type == VarType::Float16)
+            one_ptr = &h1;
+        uint32_t one = jitc_var_literal(info.backend, info.type, one_ptr, 1, 0);
         result = jitc_var_div(one, a0);
         jitc_var_dec_ref(one);
     }
@@ -1361,7 +1365,8 @@ uint32_t jitc_var_cast(uint32_t a0, VarType target_type, int reinterpret) {
     uint32_t result = 0;
     if (source_type == target_type) {
         result = jitc_var_new_ref(a0);
-    } else if (info.simplify && info.literal) {
+    } else if (info.simplify && info.literal &&
+               (reinterpret || target_type != VarType::Float16)) {
         if (reinterpret) {
             uint64_t value = v0->literal;
             result = jitc_var_literal(info.backend, info.type, &value, info.size, 0);
@@ -1542,6 +1547,8 @@ uint32_t jitc_var_gather(uint32_t src, uint32_t index, uint32_t mask) {
             index_2 = steal(jitc_scatter_gather_index(src, index)),
             mask_2  = steal(jitc_var_mask_apply(mask, var_info.size));
 
+        jitc_mmap_gather(jitc_var(src)->data);
+
         var_info.size = std::max(var_info.size, jitc_var(mask_2)->size);
 
         result = jitc_var_new_node_3(
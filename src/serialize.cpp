@@ -0,0 +1,295 @@
+/*
+    src/serialize.cpp -- Saving and loading evaluated arrays (LZ4-compressed)
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "serialize.h"
+#include "var.h"
+#include "log.h"
+#include "util.h"
+#include "malloc.h"
+#include "event.h"
+#include "llvm_pool.h"
+#include <lz4.h>
+#include <memory>
+
+/* File layout: an ArrayFileHeader, followed by 'chunk_count' ArrayChunkHeader
+   records, followed by the (compressed) data of each chunk. Chunks have an
+   uncompressed size of 'chunk_size' bytes (except for the last one), and a
+   chunk that does not compress is stored as-is. */
+
+#pragma pack(push)
+#pragma pack(1)
+struct ArrayFileHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t backend;
+    uint8_t type;
+    uint8_t unused;
+    uint32_t size;
+    uint32_t chunk_size;
+    uint32_t chunk_count;
+};
+
+struct ArrayChunkHeader {
+    /// Compressed size (equal to the uncompressed size if stored as-is)
+    uint32_t compressed_size;
+    uint32_t unused;
+
+    /// XXH3 hash of the uncompressed data
+    uint64_t hash;
+};
+#pragma pack(pop)
+
+static const char jitc_serialize_magic[4] = { 'D', 'R', 'J', 'A' };
+static const uint8_t jitc_serialize_version = 1;
+
+/// Run 'func(i)' for 'count' chunks on the thread's LLVM pool and wait (unlocked)
+template <typename Func> static void jitc_serialize_parallel(uint32_t count, Func &&func) {
+    ThreadState *ts = thread_state_llvm;
+    Pool *pool = ts ? ts->pool : nullptr;
+    unlock_guard guard(state.lock);
+    if (count == 1) {
+        func(0);
+        return;
+    }
+
+    task_wait_and_release(task_submit_dep(
+        pool, nullptr, 0, count,
+        [](uint32_t i, void *payload) { (*(Func *) payload)(i); },
+        &func, 0, nullptr, 0));
+}
+
+void jitc_var_save(uint32_t index, const char *path) {
+    jitc_var_eval(index);
+    const Variable *v = jitc_var(index);
+    JitBackend backend = (JitBackend) v->backend;
+    VarType type = (VarType) v->type;
+    uint32_t size = v->size, tsize = type_size[(int) type];
+    size_t total = (size_t) size * tsize;
+
+    if (unlikely(v->placeholder || (!v->is_data() && !v->is_literal())))
+        jitc_raise("jit_var_save(r%u): the variable cannot be evaluated!", index);
+    if (unlikely(type == VarType::Pointer || tsize == 0))
+        jitc_raise("jit_var_save(r%u): unsupported variable type!", index);
+
+    uint64_t t0 = jitc_llvm_pool_time();
+
+    // Step 1: obtain a host-accessible copy of the data
+    const uint8_t *data;
+    void *tmp = nullptr;
+    if (v->is_literal()) {
+        tmp = jitc_malloc(AllocType::Host, total);
+        for (uint32_t i = 0; i < size; ++i)
+            memcpy((uint8_t *) tmp + (size_t) i * tsize, &v->literal, tsize);
+        data = (const uint8_t *) tmp;
+    } else if (backend == JitBackend::CUDA) {
+        tmp = jitc_malloc(AllocType::HostPinned, total);
+        jitc_memcpy(backend, tmp, v->data, total);
+        data = (const uint8_t *) tmp;
+    } else {
+        Event *event = jitc_event_record(backend, index);
+        jitc_event_wait(event);
+        jitc_event_destroy(event);
+        data = (const uint8_t *) jitc_var(index)->data;
+    }
+
+    // Step 2: compress the chunks in parallel
+    uint32_t chunk_size = DRJIT_SERIALIZE_CHUNK_SIZE,
+             chunk_count = (uint32_t) ((total + chunk_size - 1) / chunk_size),
+             bound = (uint32_t) LZ4_compressBound((int) chunk_size);
+
+    std::unique_ptr<ArrayChunkHeader[]> chunks(
+        new ArrayChunkHeader[chunk_count]());
+    std::unique_ptr<uint8_t[]> compressed(
+        new uint8_t[(size_t) chunk_count * bound]);
+
+    jitc_serialize_parallel(chunk_count, [&](uint32_t i) {
+        const uint8_t *src = data + (size_t) i * chunk_size;
+        uint8_t *dst = compressed.get() + (size_t) i * bound;
+        uint32_t in_size =
+            (uint32_t) std::min((size_t) chunk_size, total - (size_t) i * chunk_size);
+
+        int rv = LZ4_compress_default((const char *) src, (char *) dst,
+                                      (int) in_size, (int) bound);
+        if (rv <= 0 || (uint32_t) rv >= in_size) {
+            memcpy(dst, src, in_size);
+            rv = (int) in_size;
+        }
+
+        chunks[i].compressed_size = (uint32_t) rv;
+        chunks[i].hash = XXH3_64bits(src, in_size);
+    });
+
+    // Step 3: write the file
+    ArrayFileHeader header;
+    memcpy(header.magic, jitc_serialize_magic, 4);
+    header.version = jitc_serialize_version;
+    header.backend = (uint8_t) backend;
+    header.type = (uint8_t) type;
+    header.unused = 0;
+    header.size = size;
+    header.chunk_size = chunk_size;
+    header.chunk_count = chunk_count;
+
+    size_t written = 0;
+    bool success;
+    {
+        unlock_guard guard(state.lock);
+        FILE *f = fopen(path, "wb");
+        success = f != nullptr;
+        if (success) {
+            success &= fwrite(&header, sizeof(ArrayFileHeader), 1, f) == 1;
+            success &= fwrite(chunks.get(), sizeof(ArrayChunkHeader),
+                              chunk_count, f) == chunk_count;
+            for (uint32_t i = 0; i < chunk_count && success; ++i) {
+                uint32_t n = chunks[i].compressed_size;
+                success &= fwrite(compressed.get() + (size_t) i * bound, 1,
+                                  n, f) == n;
+                written += n;
+            }
+            success &= fclose(f) == 0;
+        }
+    }
+
+    jitc_free(tmp);
+
+    if (!success)
+        jitc_raise("jit_var_save(r%u): could not write \"%s\": %s", index,
+                   path, strerror(errno));
+
+    float duration = (jitc_llvm_pool_time() - t0) * 1e-3f;
+    jitc_log(Info,
+             "jit_var_save(r%u -> \"%s\"): %s -> %s in %u chunk%s, %s (%.2f "
+             "GB/s).", index, path,
+             std::string(jitc_mem_string(total)).c_str(),
+             std::string(jitc_mem_string(written)).c_str(), chunk_count,
+             chunk_count > 1 ? "s" : "",
+             std::string(jitc_time_string(duration)).c_str(),
+             total / (duration * 1e3));
+}
+
+uint32_t jitc_var_load(const char *path) {
+    uint64_t t0 = jitc_llvm_pool_time();
+
+    ArrayFileHeader header;
+    std::unique_ptr<ArrayChunkHeader[]> chunks;
+    std::unique_ptr<uint8_t[]> compressed;
+    std::unique_ptr<size_t[]> offsets;
+    const char *error = nullptr;
+
+    {
+        unlock_guard guard(state.lock);
+        FILE *f = fopen(path, "rb");
+        if (!f) {
+            error = strerror(errno);
+        } else {
+            if (fread(&header, sizeof(ArrayFileHeader), 1, f) != 1 ||
+                memcmp(header.magic, jitc_serialize_magic, 4) != 0)
+                error = "not an array file";
+            else if (header.version != jitc_serialize_version)
+                error = "unsupported file format version";
+            else if (header.backend != (uint8_t) JitBackend::CUDA &&
+                     header.backend != (uint8_t) JitBackend::LLVM)
+                error = "invalid backend";
+            else if (header.type == (uint8_t) VarType::Pointer ||
+                     header.type >= (uint8_t) VarType::Count ||
+                     type_size[header.type] == 0)
+                error = "invalid variable type";
+            else if (header.chunk_size == 0 ||
+                     (size_t) header.chunk_count * header.chunk_size <
+                         (size_t) header.size * type_size[header.type])
+                error = "invalid chunk table";
+
+            if (!error) {
+                chunks.reset(new ArrayChunkHeader[header.chunk_count]);
+                offsets.reset(new size_t[header.chunk_count + 1]);
+                if (fread(chunks.get(), sizeof(ArrayChunkHeader),
+                          header.chunk_count, f) != header.chunk_count)
+                    error = "truncated chunk table";
+            }
+
+            if (!error) {
+                offsets[0] = 0;
+                for (uint32_t i = 0; i < header.chunk_count; ++i)
+                    offsets[i + 1] = offsets[i] + chunks[i].compressed_size;
+
+                size_t n = offsets[header.chunk_count];
+                compressed.reset(new uint8_t[n]);
+                if (fread(compressed.get(), 1, n, f) != n)
+                    error = "truncated file";
+            }
+
+            fclose(f);
+        }
+    }
+
+    if (error)
+        jitc_raise("jit_var_load(\"%s\"): %s!", path, error);
+
+    JitBackend backend = (JitBackend) header.backend;
+    VarType type = (VarType) header.type;
+    size_t total = (size_t) header.size * type_size[(int) type];
+
+    if (header.size == 0)
+        return 0;
+
+    /* Decompress into memory that can be handed to the variable as-is. Host
+       memory is not accessed by queued LLVM work and turns into a
+       host-asynchronous allocation without copying. */
+    void *data = jitc_malloc(backend == JitBackend::CUDA ? AllocType::HostPinned
+                                                         : AllocType::Host,
+                             total);
+
+    std::atomic<uint32_t> failed { 0 };
+    jitc_serialize_parallel(header.chunk_count, [&](uint32_t i) {
+        size_t start = (size_t) i * header.chunk_size;
+        if (start >= total)
+            return;
+
+        uint32_t out_size =
+            (uint32_t) std::min((size_t) header.chunk_size, total - start),
+                 in_size = chunks[i].compressed_size;
+        const uint8_t *src = compressed.get() + offsets[i];
+        uint8_t *dst = (uint8_t *) data + start;
+
+        if (in_size == out_size)
+            memcpy(dst, src, out_size);
+        else if (LZ4_decompress_safe((const char *) src, (char *) dst,
+                                     (int) in_size, (int) out_size) !=
+                 (int) out_size)
+            failed = 1;
+
+        if (XXH3_64bits(dst, out_size) != chunks[i].hash)
+            failed = 1;
+    });
+
+    if (failed) {
+        jitc_free(data);
+        jitc_raise("jit_var_load(\"%s\"): the file is corrupt!", path);
+    }
+
+    uint32_t index;
+    if (backend == JitBackend::CUDA) {
+        index = jitc_var_mem_copy(backend, AllocType::HostPinned, type, data,
+                                  header.size);
+        jitc_free(data);
+    } else {
+        data = jitc_malloc_migrate(data, AllocType::HostAsync, 1);
+        index = jitc_var_mem_map(backend, type, data, header.size, 1);
+    }
+
+    float duration = (jitc_llvm_pool_time() - t0) * 1e-3f;
+    jitc_log(Info,
+             "jit_var_load(r%u <- \"%s\"): %s in %u chunk%s, %s (%.2f GB/s).",
+             index, path, std::string(jitc_mem_string(total)).c_str(),
+             header.chunk_count, header.chunk_count > 1 ? "s" : "",
+             std::string(jitc_time_string(duration)).c_str(),
+             total / (duration * 1e3));
+
+    return index;
+}
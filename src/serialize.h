@@ -0,0 +1,21 @@
+/*
+    src/serialize.h -- Saving and loading evaluated arrays (LZ4-compressed)
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include "internal.h"
+
+/// Uncompressed size of the chunks that are compressed in parallel
+#define DRJIT_SERIALIZE_CHUNK_SIZE (4 * 1024 * 1024)
+
+/// Write the contents of a variable to a file (see jit.h)
+extern void jitc_var_save(uint32_t index, const char *path);
+
+/// Load a variable from a file written by \ref jitc_var_save() (see jit.h)
+extern uint32_t jitc_var_load(const char *path);
@@ -0,0 +1,406 @@
+/*
+    src/shard.cpp -- Arrays sharded across processes and collective operations
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "shard.h"
+#include "var.h"
+#include "op.h"
+#include "log.h"
+#include "util.h"
+#include "malloc.h"
+#include <atomic>
+#include <chrono>
+#include <type_traits>
+
+#if defined(__linux__)
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sched.h>
+#endif
+
+/// Process group that the sharding layer is currently bound to
+struct Shard {
+    uint32_t rank = 0;
+    uint32_t size = 1;
+    ShardAllGather func = nullptr;
+    void *payload = nullptr;
+
+    /// Release the transport-specific payload (e.g. a shared memory region)
+    void (*release)(void *payload) = nullptr;
+};
+
+static Shard jitc_shard;
+
+/// Contribution of a rank to a collective reduction
+struct ShardValue {
+    uint64_t value;
+    uint32_t valid;
+    uint32_t padding;
+};
+
+// ====================================================================
+//                     Shared memory transport
+// ====================================================================
+
+#if defined(__linux__)
+/// Header of the shared memory region, followed by one slot per rank
+struct ShmHeader {
+    /// Number of ranks (set by the first process that joins)
+    std::atomic<uint32_t> size;
+
+    /// Sense-reversing barrier
+    std::atomic<uint32_t> arrived;
+    std::atomic<uint32_t> generation;
+};
+
+struct ShmRegion {
+    ShmHeader *header;
+    size_t bytes;
+    uint32_t rank;
+    uint32_t size;
+};
+
+/**
+ * Wait until all ranks have arrived. Returns \c false if this took longer than
+ * \ref DRJIT_SHARD_SHM_TIMEOUT seconds (e.g. because a process crashed), in
+ * which case the state of the barrier is undefined. Called without the lock.
+ */
+static bool jitc_shard_shm_barrier(ShmRegion *r) {
+    ShmHeader *h = r->header;
+    uint32_t generation = h->generation.load(std::memory_order_acquire);
+
+    if (h->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == r->size) {
+        h->arrived.store(0, std::memory_order_relaxed);
+        h->generation.fetch_add(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::seconds(DRJIT_SHARD_SHM_TIMEOUT);
+
+    for (uint32_t i = 0; h->generation.load(std::memory_order_acquire) ==
+                         generation; ++i) {
+        if (i > 1024) {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            sched_yield();
+        }
+    }
+
+    return true;
+}
+
+/// Report a barrier timeout (the caller doesn't hold the lock)
+static void jitc_shard_shm_timeout(const char *func, ShmRegion *r) {
+    lock_guard guard(state.lock);
+    jitc_raise("%s(): rank %u waited for more than %u seconds for the other "
+               "processes of the group, which may have crashed. The group "
+               "must be re-initialized via jit_shard_init_shm().",
+               func, r->rank, (uint32_t) DRJIT_SHARD_SHM_TIMEOUT);
+}
+
+static void jitc_shard_shm_allgather(const void *in, void *out, size_t size,
+                                     void *payload) {
+    ShmRegion *r = (ShmRegion *) payload;
+    uint8_t *slots = (uint8_t *) (r->header + 1);
+
+    memcpy(slots + (size_t) r->rank * DRJIT_SHARD_SLOT_SIZE, in, size);
+    if (!jitc_shard_shm_barrier(r))
+        jitc_shard_shm_timeout("jit_shard_allgather", r);
+
+    for (uint32_t i = 0; i < r->size; ++i)
+        memcpy((uint8_t *) out + i * size,
+               slots + (size_t) i * DRJIT_SHARD_SLOT_SIZE, size);
+
+    // Don't let a fast rank overwrite its slot before everyone has read it
+    if (!jitc_shard_shm_barrier(r))
+        jitc_shard_shm_timeout("jit_shard_allgather", r);
+}
+
+static void jitc_shard_shm_release(void *payload) {
+    ShmRegion *r = (ShmRegion *) payload;
+    munmap(r->header, r->bytes);
+    delete r;
+}
+
+void jitc_shard_init_shm(const char *name, uint32_t rank, uint32_t size) {
+    if (unlikely(size == 0 || rank >= size))
+        jitc_raise("jit_shard_init_shm(): invalid rank %u for a group of "
+                   "size %u!", rank, size);
+
+    // POSIX shared memory object names must start with a slash
+    std::string path = name[0] == '/' ? name : std::string("/") + name;
+    size_t bytes = sizeof(ShmHeader) + (size_t) size * DRJIT_SHARD_SLOT_SIZE;
+
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0)
+        jitc_raise("jit_shard_init_shm(): could not open \"%s\": %s",
+                   path.c_str(), strerror(errno));
+
+    // The region is zero-initialized, which is a valid initial state
+    void *ptr = MAP_FAILED;
+    if (ftruncate(fd, (off_t) bytes) == 0)
+        ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int errno_saved = errno;
+    close(fd);
+
+    if (ptr == MAP_FAILED)
+        jitc_raise("jit_shard_init_shm(): could not map \"%s\": %s",
+                   path.c_str(), strerror(errno_saved));
+
+    ShmHeader *header = (ShmHeader *) ptr;
+    uint32_t expected = 0;
+    if (!header->size.compare_exchange_strong(expected, size) &&
+        expected != size) {
+        munmap(ptr, bytes);
+        jitc_raise("jit_shard_init_shm(): \"%s\" belongs to a group of size "
+                   "%u, but this process requested size %u!", path.c_str(),
+                   expected, size);
+    }
+
+    jitc_shard_shutdown();
+
+    ShmRegion *r = new ShmRegion{ header, bytes, rank, size };
+
+    bool success;
+    /* Scope */ {
+        // Wait until all ranks have mapped the region
+        unlock_guard guard(state.lock);
+        success = jitc_shard_shm_barrier(r);
+    }
+
+    if (unlikely(!success)) {
+        shm_unlink(path.c_str());
+        jitc_shard_shm_release(r);
+        jitc_raise("jit_shard_init_shm(\"%s\"): only some of the %u processes "
+                   "joined the group within %u seconds!", path.c_str(), size,
+                   (uint32_t) DRJIT_SHARD_SHM_TIMEOUT);
+    }
+
+    // Remove the name, the region itself persists while it is mapped
+    if (rank == 0)
+        shm_unlink(path.c_str());
+
+    jitc_shard = Shard{ rank, size, jitc_shard_shm_allgather, r,
+                        jitc_shard_shm_release };
+
+    jitc_log(Info, "jit_shard_init_shm(\"%s\"): joined as rank %u of %u.",
+             path.c_str(), rank, size);
+}
+#else
+void jitc_shard_init_shm(const char *, uint32_t, uint32_t) {
+    jitc_raise("jit_shard_init_shm(): only supported on Linux!");
+}
+#endif
+
+// ====================================================================
+//                         Group management
+// ====================================================================
+
+void jitc_shard_init(uint32_t rank, uint32_t size, ShardAllGather func,
+                     void *payload) {
+    if (unlikely(size == 0 || rank >= size))
+        jitc_raise("jit_shard_init(): invalid rank %u for a group of size %u!",
+                   rank, size);
+    if (unlikely(!func && size > 1))
+        jitc_raise("jit_shard_init(): a transport is required for groups "
+                   "with more than one process!");
+
+    jitc_shard_shutdown();
+    jitc_shard = Shard{ rank, size, func, payload, nullptr };
+
+    jitc_log(Info, "jit_shard_init(): joined as rank %u of %u.", rank, size);
+}
+
+void jitc_shard_shutdown() {
+    if (jitc_shard.release)
+        jitc_shard.release(jitc_shard.payload);
+    jitc_shard = Shard();
+}
+
+uint32_t jitc_shard_rank() { return jitc_shard.rank; }
+uint32_t jitc_shard_size() { return jitc_shard.size; }
+
+uint32_t jitc_shard_slice(size_t size, size_t *offset) {
+    size_t n = jitc_shard.size, r = jitc_shard.rank,
+           chunk = size / n, rem = size % n,
+           count = chunk + (r < rem ? 1 : 0),
+           start = r * chunk + std::min(r, rem);
+
+    if (unlikely(count > 0xFFFFFFFF))
+        jitc_raise("jit_shard_slice(): the slice of rank %zu has %zu entries, "
+                   "which exceeds the limit of 2^32 == 4294967296 entries.",
+                   r, count);
+
+    if (offset)
+        *offset = start;
+    return (uint32_t) count;
+}
+
+/// Exchange 'size' bytes per rank. 'out' receives the data of all ranks.
+static void jitc_shard_allgather(const void *in, void *out, size_t size) {
+    if (jitc_shard.size == 1) {
+        memcpy(out, in, size);
+        return;
+    }
+
+    if (unlikely(size > DRJIT_SHARD_SLOT_SIZE))
+        jitc_fail("jit_shard_allgather(): payload too large!");
+
+    // Other ranks may take a while to arrive, don't block the JIT meanwhile
+    unlock_guard guard(state.lock);
+    jitc_shard.func(in, out, size, jitc_shard.payload);
+}
+
+// ====================================================================
+//                        Collective operations
+// ====================================================================
+
+template <typename T> static T jitc_shard_combine(ReduceOp op, T a, T b) {
+    switch (op) {
+        case ReduceOp::Add: return (T) (a + b);
+        case ReduceOp::Mul: return (T) (a * b);
+        case ReduceOp::Min: return std::min(a, b);
+        case ReduceOp::Max: return std::max(a, b);
+        default:
+            if constexpr (std::is_integral_v<T>) {
+                if (op == ReduceOp::And)
+                    return (T) (a & b);
+                else if (op == ReduceOp::Or)
+                    return (T) (a | b);
+            }
+            jitc_raise("jit_reduce_all(): unsupported reduction for type!");
+    }
+}
+
+template <typename T>
+static void jitc_shard_combine_all(ReduceOp op, const ShardValue *values,
+                                   uint32_t count, uint64_t *out) {
+    bool found = false;
+    T acc = T(0);
+    for (uint32_t i = 0; i < count; ++i) {
+        if (!values[i].valid)
+            continue;
+        T value;
+        memcpy(&value, &values[i].value, sizeof(T));
+        acc = found ? jitc_shard_combine(op, acc, value) : value;
+        found = true;
+    }
+    if (found)
+        memcpy(out, &acc, sizeof(T));
+}
+
+/**
+ * Combine the (host-side) partial reductions 'local' of all ranks. Ranks whose
+ * slice is empty set 'valid' to \c false and receive the result of the others.
+ */
+static uint64_t jitc_shard_allreduce(VarType type, ReduceOp op,
+                                     uint64_t local, bool valid) {
+    ShardValue in { local, valid ? 1u : 0u, 0 };
+    std::unique_ptr<ShardValue[]> values(new ShardValue[jitc_shard.size]);
+    jitc_shard_allgather(&in, values.get(), sizeof(ShardValue));
+
+    uint64_t result = local;
+    const ShardValue *v = values.get();
+    uint32_t n = jitc_shard.size;
+    switch (type) {
+        case VarType::Bool:    jitc_shard_combine_all<bool>    (op, v, n, &result); break;
+        case VarType::Int8:    jitc_shard_combine_all<int8_t>  (op, v, n, &result); break;
+        case VarType::UInt8:   jitc_shard_combine_all<uint8_t> (op, v, n, &result); break;
+        case VarType::Int16:   jitc_shard_combine_all<int16_t> (op, v, n, &result); break;
+        case VarType::UInt16:  jitc_shard_combine_all<uint16_t>(op, v, n, &result); break;
+        case VarType::Int32:   jitc_shard_combine_all<int32_t> (op, v, n, &result); break;
+        case VarType::UInt32:  jitc_shard_combine_all<uint32_t>(op, v, n, &result); break;
+        case VarType::Int64:   jitc_shard_combine_all<int64_t> (op, v, n, &result); break;
+        case VarType::UInt64:  jitc_shard_combine_all<uint64_t>(op, v, n, &result); break;
+        case VarType::Float32: jitc_shard_combine_all<float>   (op, v, n, &result); break;
+        case VarType::Float64: jitc_shard_combine_all<double>  (op, v, n, &result); break;
+        default: jitc_raise("jit_reduce_all(): unsupported operand type!");
+    }
+    return result;
+}
+
+void jitc_reduce_all(JitBackend backend, VarType type, ReduceOp reduce_op,
+                     const void *ptr, uint32_t size, void *out) {
+    uint32_t tsize = type_size[(int) type];
+    AllocType atype = backend == JitBackend::CUDA ? AllocType::Device
+                                                  : AllocType::HostAsync;
+
+    uint64_t local = 0;
+    if (size) {
+        void *tmp = jitc_malloc(atype, tsize);
+        jitc_reduce(backend, type, reduce_op, ptr, size, tmp);
+        jitc_memcpy(backend, &local, tmp, tsize);
+        jitc_free(tmp);
+    }
+
+    uint64_t result = jitc_shard_allreduce(type, reduce_op, local, size != 0);
+    jitc_memset_async(backend, out, 1, tsize, &result);
+}
+
+uint32_t jitc_scan_u32_all(JitBackend backend, const uint32_t *in,
+                           uint32_t size, uint32_t *out) {
+    AllocType atype = backend == JitBackend::CUDA ? AllocType::Device
+                                                  : AllocType::HostAsync;
+
+    // Compute the total before a potential in-place scan overwrites 'in'
+    uint32_t total = 0;
+    if (size) {
+        uint32_t *tmp = (uint32_t *) jitc_malloc(atype, sizeof(uint32_t));
+        jitc_reduce(backend, VarType::UInt32, ReduceOp::Add, in, size, tmp);
+        jitc_scan_u32(backend, in, size, out);
+        jitc_memcpy(backend, &total, tmp, sizeof(uint32_t));
+        jitc_free(tmp);
+    }
+
+    std::unique_ptr<uint32_t[]> totals(new uint32_t[jitc_shard.size]);
+    jitc_shard_allgather(&total, totals.get(), sizeof(uint32_t));
+
+    uint32_t offset = 0, sum = 0;
+    for (uint32_t i = 0; i < jitc_shard.size; ++i) {
+        if (i == jitc_shard.rank)
+            offset = sum;
+        sum += totals[i];
+    }
+
+    if (offset && size) {
+        // Shift the local prefix sum by the totals of the preceding ranks
+        uint32_t v0 = jitc_var_mem_map(backend, VarType::UInt32, out, size, 0),
+                 v1 = jitc_var_literal(backend, VarType::UInt32, &offset, 1, 0),
+                 v2 = jitc_var_add(v0, v1);
+        jitc_var_eval(v2);
+        jitc_memcpy_async(backend, out, jitc_var(v2)->data,
+                          (size_t) size * sizeof(uint32_t));
+        jitc_var_dec_ref(v2);
+        jitc_var_dec_ref(v1);
+        jitc_var_dec_ref(v0);
+    }
+
+    jitc_log(Debug, "jit_scan_u32_all(size=%u): rank offset=%u, total=%u", size,
+             offset, sum);
+
+    return sum;
+}
+
+uint32_t jitc_var_reduce_all(uint32_t index, ReduceOp reduce_op) {
+    if (unlikely(index == 0))
+        jitc_raise("jit_var_reduce_all(): the variable is uninitialized!");
+
+    const Variable *v = jitc_var(index);
+    JitBackend backend = (JitBackend) v->backend;
+    VarType type = (VarType) v->type;
+
+    uint64_t local = 0;
+    uint32_t partial = jitc_var_reduce(index, reduce_op);
+    jitc_var_read(partial, 0, &local);
+    jitc_var_dec_ref(partial);
+
+    uint64_t result = jitc_shard_allreduce(type, reduce_op, local, true);
+    return jitc_var_literal(backend, type, &result, 1, 0);
+}
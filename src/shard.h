@@ -0,0 +1,50 @@
+/*
+    src/shard.h -- Arrays sharded across processes and collective operations
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include "internal.h"
+
+/// Maximum number of bytes that a rank contributes to a single all-gather
+#define DRJIT_SHARD_SLOT_SIZE 64
+
+/// Time (in seconds) after which a rank stops waiting for the rest of its group
+#define DRJIT_SHARD_SHM_TIMEOUT 60
+
+/// Join a group of processes that communicate via a custom transport (see jit.h)
+extern void jitc_shard_init(uint32_t rank, uint32_t size,
+                            ShardAllGather func, void *payload);
+
+/// Join a group of processes that communicate via shared memory (see jit.h)
+extern void jitc_shard_init_shm(const char *name, uint32_t rank,
+                                uint32_t size);
+
+/// Leave the current group and release the associated transport
+extern void jitc_shard_shutdown();
+
+/// Return the rank of this process within the group
+extern uint32_t jitc_shard_rank();
+
+/// Return the number of processes of the group
+extern uint32_t jitc_shard_size();
+
+/// Compute the slice of a logical array owned by this process (see jit.h)
+extern uint32_t jitc_shard_slice(size_t size, size_t *offset);
+
+/// Collective variant of \ref jitc_reduce() (see jit.h)
+extern void jitc_reduce_all(JitBackend backend, VarType type,
+                            ReduceOp reduce_op, const void *ptr,
+                            uint32_t size, void *out);
+
+/// Collective variant of \ref jitc_scan_u32() (see jit.h)
+extern uint32_t jitc_scan_u32_all(JitBackend backend, const uint32_t *in,
+                                  uint32_t size, uint32_t *out);
+
+/// Collective variant of \ref jitc_var_reduce() (see jit.h)
+extern uint32_t jitc_var_reduce_all(uint32_t index, ReduceOp reduce_op);
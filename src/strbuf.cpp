@@ -630,6 +630,13 @@ void StringBuffer::fmt_llvm(size_t nargs, const char *fmt, ...) {
                             *m_cur ++= '0';
                             *m_cur ++= 'x';
                             put_x64_unchecked(literal);
+                        } else if (vt == VarType::Float16) {
+                            // Half precision constants use a special syntax
+                            *m_cur ++= '0';
+                            *m_cur ++= 'x';
+                            *m_cur ++= 'H';
+                            for (int i = 3; i >= 0; --i)
+                                *m_cur ++= num[(literal >> (i * 4)) & 0xF];
                         } else {
                             put_u64_unchecked(literal);
                         }
@@ -0,0 +1,238 @@
+/*
+    src/stream.cpp -- Chunk-by-chunk evaluation over out-of-core inputs
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#include "stream.h"
+#include "var.h"
+#include "log.h"
+#include "eval.h"
+#include "util.h"
+#include "malloc.h"
+#include "event.h"
+#include <memory>
+
+#if !defined(_WIN32)
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+/**
+ * Chunks are processed using two sets of buffers ("slots") in alternation.
+ * While the kernels of chunk 'i' run asynchronously, the host reads chunk
+ * 'i+1' into the other slot, which only requires waiting for chunk 'i-1'.
+ */
+struct StreamSlot {
+    /// Per-input host buffer that receives data from the source
+    std::unique_ptr<void *[]> staging;
+
+    /// Per-input buffer referenced by variables (CUDA: device memory)
+    std::unique_ptr<void *[]> buffer;
+
+    /// Completes once the slot is no longer accessed by queued work
+    Event *event = nullptr;
+};
+
+struct StreamState {
+    JitBackend backend;
+    uint32_t input_count;
+    const StreamInput *inputs;
+    uint32_t chunk_size;
+    StreamSlot slots[2];
+    std::unique_ptr<int[]> fds;
+
+    ~StreamState() {
+        for (StreamSlot &slot : slots) {
+            if (slot.event) {
+                jitc_event_wait(slot.event);
+                jitc_event_destroy(slot.event);
+            }
+            for (uint32_t i = 0; i < input_count; ++i) {
+                if (slot.staging && slot.staging[i] != slot.buffer[i])
+                    jitc_free(slot.staging[i]);
+                if (slot.buffer)
+                    jitc_free(slot.buffer[i]);
+            }
+        }
+#if !defined(_WIN32)
+        for (uint32_t i = 0; i < input_count; ++i) {
+            if (fds && fds[i] >= 0)
+                close(fds[i]);
+        }
+#endif
+    }
+
+    size_t chunk_bytes(uint32_t i) const {
+        return (size_t) chunk_size * type_size[(int) inputs[i].type];
+    }
+};
+
+static void *jitc_stream_alloc_buffer(JitBackend backend, size_t size) {
+    return jitc_malloc(backend == JitBackend::CUDA ? AllocType::Device
+                                                   : AllocType::HostAsync,
+                       size);
+}
+
+/// Read elements [start, start + count) of all inputs into a slot (unlocked)
+static void jitc_stream_read(StreamState &s, StreamSlot &slot, size_t start,
+                             uint32_t count) {
+    for (uint32_t i = 0; i < s.input_count; ++i) {
+        const StreamInput &in = s.inputs[i];
+        uint32_t tsize = type_size[(int) in.type];
+
+        if (in.read) {
+            in.read(in.payload, start, count, slot.staging[i]);
+            continue;
+        }
+
+#if !defined(_WIN32)
+        uint8_t *dst = (uint8_t *) slot.staging[i];
+        size_t remain = (size_t) count * tsize,
+               offset = in.offset + start * tsize;
+
+        while (remain) {
+            ssize_t rv = pread(s.fds[i], dst, remain, (off_t) offset);
+            if (rv <= 0)
+                jitc_raise("jit_stream(): could not read %zu bytes at offset "
+                           "%zu of \"%s\"!", remain, offset, in.path);
+            dst += rv;
+            offset += (size_t) rv;
+            remain -= (size_t) rv;
+        }
+#endif
+    }
+}
+
+void jitc_stream(JitBackend backend, size_t size, uint32_t chunk_size,
+                 uint32_t input_count, const StreamInput *inputs,
+                 void (*body)(void *payload, size_t start, uint32_t count,
+                              const uint32_t *in),
+                 void *payload) {
+    if (size == 0)
+        return;
+    if (chunk_size == 0)
+        chunk_size = DRJIT_STREAM_CHUNK_SIZE;
+    if (size < chunk_size)
+        chunk_size = (uint32_t) size;
+    if (!body)
+        jitc_raise("jit_stream(): 'body' must be specified!");
+
+    StreamState s;
+    s.backend = backend;
+    s.input_count = input_count;
+    s.inputs = inputs;
+    s.chunk_size = chunk_size;
+    s.fds.reset(new int[input_count]);
+
+    for (uint32_t i = 0; i < input_count; ++i) {
+        const StreamInput &in = inputs[i];
+        s.fds[i] = -1;
+
+        if (type_size[(int) in.type] == 0 || in.type == VarType::Pointer)
+            jitc_raise("jit_stream(): input %u has an unsupported type!", i);
+
+        if (!in.read) {
+            if (!in.path)
+                jitc_raise("jit_stream(): input %u requires a 'read' "
+                           "callback or a file 'path'!", i);
+#if !defined(_WIN32)
+            s.fds[i] = open(in.path, O_RDONLY | O_CLOEXEC);
+            if (s.fds[i] < 0)
+                jitc_raise("jit_stream(): could not open \"%s\": %s",
+                           in.path, strerror(errno));
+#else
+            jitc_raise("jit_stream(): file inputs are not supported on "
+                       "Windows!");
+#endif
+        }
+    }
+
+    /* The initial events cover earlier work that could still access the
+       (recycled) memory of the slots */
+    for (StreamSlot &slot : s.slots) {
+        slot.staging.reset(new void *[input_count]());
+        slot.buffer.reset(new void *[input_count]());
+        for (uint32_t i = 0; i < input_count; ++i) {
+            size_t bytes = s.chunk_bytes(i);
+            slot.buffer[i] = jitc_stream_alloc_buffer(backend, bytes);
+            slot.staging[i] = backend == JitBackend::CUDA
+                                  ? jitc_malloc(AllocType::HostPinned, bytes)
+                                  : slot.buffer[i];
+        }
+        slot.event = jitc_event_record(backend, 0);
+    }
+
+    ThreadState *ts = thread_state(backend);
+    size_t chunk_count = (size - 1) / chunk_size + 1;
+    std::unique_ptr<uint32_t[]> vars(new uint32_t[input_count]);
+
+    jitc_log(Info, "jit_stream(): processing %zu elements in %zu chunk%s of "
+             "size %u.", size, chunk_count, chunk_count > 1 ? "s" : "",
+             chunk_size);
+
+    auto prefetch = [&](size_t chunk) {
+        StreamSlot &slot = s.slots[chunk % 2];
+        size_t start = chunk * chunk_size;
+        uint32_t count = (uint32_t) std::min((size_t) chunk_size, size - start);
+
+        jitc_event_wait(slot.event);
+        unlock_guard guard(state.lock);
+        jitc_stream_read(s, slot, start, count);
+    };
+
+    prefetch(0);
+
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        StreamSlot &slot = s.slots[chunk % 2];
+        size_t start = chunk * chunk_size;
+        uint32_t count = (uint32_t) std::min((size_t) chunk_size, size - start);
+
+        for (uint32_t i = 0; i < input_count; ++i) {
+            VarType type = inputs[i].type;
+            if (backend == JitBackend::CUDA)
+                jitc_memcpy_async(backend, slot.buffer[i], slot.staging[i],
+                                  (size_t) count * type_size[(int) type]);
+            vars[i] =
+                jitc_var_mem_map(backend, type, slot.buffer[i], count, 0);
+        }
+
+        try {
+            unlock_guard guard(state.lock);
+            body(payload, start, count, vars.get());
+        } catch (...) {
+            for (uint32_t i = 0; i < input_count; ++i)
+                jitc_var_dec_ref(vars[i]);
+            throw;
+        }
+
+        /* Launch the kernels of this chunk. The body was traced again above,
+           but the IR only differs in the size of the inputs, hence the
+           kernels are found in the kernel cache after the first chunk. */
+        jitc_eval(ts);
+
+        for (uint32_t i = 0; i < input_count; ++i) {
+            Variable *v = jitc_var(vars[i]);
+            if (v->ref_count > 1) {
+                /* The body retained a reference to the input. Hand the buffer
+                   over to the variable and allocate a new one for the slot. */
+                v->retain_data = false;
+                slot.buffer[i] =
+                    jitc_stream_alloc_buffer(backend, s.chunk_bytes(i));
+                if (backend == JitBackend::LLVM)
+                    slot.staging[i] = slot.buffer[i];
+            }
+            jitc_var_dec_ref(vars[i]);
+        }
+
+        jitc_event_destroy(slot.event);
+        slot.event = jitc_event_record(backend, 0);
+
+        // Overlap reading the next chunk with the computation of this one
+        if (chunk + 1 < chunk_count)
+            prefetch(chunk + 1);
+    }
+}
@@ -0,0 +1,22 @@
+/*
+    src/stream.h -- Chunk-by-chunk evaluation over out-of-core inputs
+
+    Copyright (c) 2021 Wenzel Jakob <wenzel.jakob@epfl.ch>
+
+    All rights reserved. Use of this source code is governed by a BSD-style
+    license that can be found in the LICENSE file.
+*/
+
+#pragma once
+
+#include "internal.h"
+
+/// Default number of elements per chunk of \ref jitc_stream()
+#define DRJIT_STREAM_CHUNK_SIZE (1u << 22)
+
+/// Process a large input chunk by chunk (see jit.h)
+extern void jitc_stream(JitBackend backend, size_t size, uint32_t chunk_size,
+                        uint32_t input_count, const StreamInput *inputs,
+                        void (*body)(void *payload, size_t start,
+                                     uint32_t count, const uint32_t *in),
+                        void *payload);
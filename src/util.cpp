@@ -8,6 +8,7 @@
 */
 
 #include <condition_variable>
+#include <memory>
 #include "internal.h"
 #include "util.h"
 #include "var.h"
@@ -15,6 +16,10 @@
 #include "log.h"
 #include "vcall.h"
 #include "profiler.h"
+#include "llvm_pool.h"
+#include "cow.h"
+#include "event.h"
+#include "op.h"
 
 #if defined(_MSC_VER)
 #  pragma warning (disable: 4146) // unary minus operator applied to unsigned type, result still unsigned
@@ -35,11 +40,20 @@ void jitc_submit_cpu(KernelType type, Func &&func, uint32_t width,
     static_assert(std::is_trivially_copyable<Payload>::value &&
                   std::is_trivially_destructible<Payload>::value, "Internal error!");
 
+    ThreadState *ts = thread_state(JitBackend::LLVM);
+    Task *&task_head = jitc_task_head(ts);
+
     Task *new_task = task_submit_dep(
-        nullptr, &jitc_task, 1, size,
-        [](uint32_t index, void *payload) { ((Payload *) payload)->f(index); },
+        ts->pool, &task_head, 1, size,
+        [](uint32_t index, void *payload) {
+            uint64_t t0 = jitc_llvm_pool_time();
+            ((Payload *) payload)->f(index);
+            jitc_llvm_pool_account(t0);
+        },
         &payload, sizeof(Payload), nullptr, (int) always_async);
 
+    jitc_llvm_pool_launch(ts);
+
     if (unlikely(jit_flag(JitFlag::LaunchBlocking)))
         task_wait(new_task);
 
@@ -56,9 +70,9 @@ void jitc_submit_cpu(KernelType type, Func &&func, uint32_t width,
     }
 
     if (release_prev)
-        task_release(jitc_task);
+        task_release(task_head);
 
-    jitc_task = new_task;
+    task_head = new_task;
 }
 
 void jitc_submit_gpu(KernelType type, CUfunction kernel, uint32_t block_count,
@@ -228,6 +242,18 @@ void jitc_memcpy_async(JitBackend backend, void *dst, const void *src, size_t si
     }
 }
 
+void jitc_memcpy_async_cow(void *dst, const void *src, size_t size) {
+    jitc_submit_cpu(
+        KernelType::Other,
+        [dst, src, size](uint32_t) {
+            if (!jitc_cow_copy(dst, src, size))
+                memcpy(dst, src, size);
+        },
+
+        (uint32_t) size
+    );
+}
+
 using Reduction = void (*) (const void *ptr, uint32_t start, uint32_t end, void *out);
 
 template <typename Value>
@@ -1008,7 +1034,7 @@ uint32_t jitc_mkperm(JitBackend backend, const uint32_t *ptr, uint32_t size,
             size
         );
 
-        Task *local_task = jitc_task;
+        Task *local_task = jitc_task_head(thread_state(JitBackend::LLVM));
 
         // Phase 2
         jitc_submit_cpu(
@@ -1225,6 +1251,82 @@ void jitc_block_sum(JitBackend backend, enum VarType type, const void *in, void
     }
 }
 
+using SpmvOp = void (*) (const uint32_t *offsets, const uint32_t *cols,
+                         const void *values, const void *x, void *out,
+                         uint32_t start, uint32_t end);
+
+template <typename Value> static SpmvOp jitc_spmv_csr_create() {
+    return [](const uint32_t *offsets, const uint32_t *cols,
+              const void *values_, const void *x_, void *out_,
+              uint32_t start, uint32_t end) {
+        const Value *values = (const Value *) values_,
+                    *x = (const Value *) x_;
+        Value *out = (Value *) out_;
+        for (uint32_t i = start; i != end; ++i) {
+            Value sum = 0;
+            for (uint32_t j = offsets[i], j_end = offsets[i + 1]; j != j_end; ++j)
+                sum += values[j] * x[cols[j]];
+            out[i] = sum;
+        }
+    };
+}
+
+static SpmvOp jitc_spmv_csr_create(VarType type) {
+    switch (type) {
+        case VarType::Float32: return jitc_spmv_csr_create<float >();
+        case VarType::Float64: return jitc_spmv_csr_create<double>();
+        default: jitc_raise("jit_spmv_csr(): unsupported data type!");
+    }
+}
+
+/// Sparse matrix-vector product with a matrix in CSR format
+void jitc_spmv_csr(JitBackend backend, VarType type, const uint32_t *offsets,
+                   const uint32_t *cols, const void *values, const void *x,
+                   void *out, uint32_t rows, uint32_t nnz) {
+    jitc_log(Debug,
+            "jit_spmv_csr(" DRJIT_PTR " -> " DRJIT_PTR
+            ", type=%s, rows=%u, nnz=%u)",
+            (uintptr_t) values, (uintptr_t) out, type_name[(int) type], rows,
+            nnz);
+
+    if (backend != JitBackend::LLVM)
+        jitc_raise("jit_spmv_csr(): only supported by the LLVM backend!");
+    if (rows == 0)
+        return;
+
+    SpmvOp op = jitc_spmv_csr_create(type);
+
+    /* Balance the work units by the number of nonzeros instead of rows.
+       Each unit processes the rows whose first nonzero falls into its range
+       of 'nnz_per_unit' entries (empty rows are assigned the same way). The
+       row range is found via binary search once 'offsets' is available. */
+    uint32_t nnz_per_unit = std::max(nnz, 1u), work_units = 1;
+    if (pool_size() > 1 && nnz > DRJIT_POOL_BLOCK_SIZE) {
+        nnz_per_unit = DRJIT_POOL_BLOCK_SIZE;
+        work_units   = (nnz + nnz_per_unit - 1) / nnz_per_unit;
+    }
+
+    jitc_submit_cpu(
+        KernelType::Other,
+        [offsets, cols, values, x, out, op, rows, nnz_per_unit,
+         work_units](uint32_t index) {
+            uint64_t base = offsets[0],
+                     lo = base + (uint64_t) index * nnz_per_unit,
+                     hi = lo + nnz_per_unit;
+
+            uint32_t start = 0, end = rows;
+            if (index != 0)
+                start = (uint32_t) (std::lower_bound(offsets, offsets + rows, lo) - offsets);
+            if (index + 1 != work_units)
+                end = (uint32_t) (std::lower_bound(offsets, offsets + rows, hi) - offsets);
+
+            op(offsets, cols, values, x, out, start, end);
+        },
+
+        nnz, work_units
+    );
+}
+
 /// Asynchronously update a single element in memory
 void jitc_poke(JitBackend backend, void *dst, const void *src, uint32_t size) {
     jitc_log(Debug, "jit_poke(" DRJIT_PTR ", size=%u)", (uintptr_t) dst, size);
@@ -1325,3 +1427,303 @@ void jitc_vcall_prepare(JitBackend backend, void *dst_, VCallDataRecord *rec_, u
             true, true);
     }
 }
+
+// --------------------------------------------------------------------------
+//  Conversion between array-of-structures and structure-of-arrays layouts
+// --------------------------------------------------------------------------
+
+/// A field of a record in an AoS buffer and the associated SoA array
+struct AosField {
+    uint8_t *soa;
+    size_t offset;
+    uint32_t isize;
+
+    /// Set to zero when a single SoA entry should be broadcast (SoA -> AoS)
+    uint32_t soa_stride;
+};
+
+template <typename T, bool ToSoA>
+static void jitc_aos_copy_field(uint8_t *aos, size_t stride,
+                                const AosField &f, uint32_t start,
+                                uint32_t end) {
+    uint8_t *p = aos + (size_t) start * stride + f.offset,
+            *q = f.soa + (size_t) start * f.soa_stride;
+
+    for (uint32_t i = start; i != end; ++i) {
+        if (ToSoA)
+            memcpy(q, p, sizeof(T));
+        else
+            memcpy(p, q, sizeof(T));
+        p += stride;
+        q += f.soa_stride;
+    }
+}
+
+template <bool ToSoA>
+static void jitc_aos_copy_block(uint8_t *aos, size_t stride,
+                                const AosField &f, uint32_t start,
+                                uint32_t end) {
+    switch (f.isize) {
+        case 1: jitc_aos_copy_field<uint8_t,  ToSoA>(aos, stride, f, start, end); break;
+        case 2: jitc_aos_copy_field<uint16_t, ToSoA>(aos, stride, f, start, end); break;
+        case 4: jitc_aos_copy_field<uint32_t, ToSoA>(aos, stride, f, start, end); break;
+        case 8: jitc_aos_copy_field<uint64_t, ToSoA>(aos, stride, f, start, end); break;
+        default: jitc_fail("jit_aos_copy_block(): invalid field size!");
+    }
+}
+
+/**
+ * \brief Convert between AoS and SoA layouts on the host using the thread pool
+ * (synchronous, must be called without holding the lock)
+ *
+ * Records are processed in blocks that fit into the L2 cache. Within each
+ * block, the fields are copied one after the other using tight loops with
+ * a compile-time element size that the compiler can vectorize.
+ */
+static void jitc_aos_convert(bool to_soa, uint8_t *aos, size_t stride,
+                             uint32_t count, uint32_t field_count,
+                             const AosField *fields) {
+    struct Payload {
+        uint8_t *aos;
+        size_t stride;
+        uint32_t count, block_size, field_count;
+        bool to_soa;
+        const AosField *fields;
+    };
+
+    uint32_t block_size =
+        (uint32_t) std::max((size_t) 64, (size_t) (128 * 1024) / stride);
+    uint32_t blocks = (count + block_size - 1) / block_size;
+
+    Payload payload{ aos, stride, count, block_size, field_count, to_soa, fields };
+
+    auto callback = [](uint32_t index, void *ptr) {
+        const Payload &p = *(Payload *) ptr;
+        uint32_t start = index * p.block_size,
+                 end = std::min(start + p.block_size, p.count);
+
+        for (uint32_t j = 0; j < p.field_count; ++j) {
+            if (p.to_soa)
+                jitc_aos_copy_block<true>(p.aos, p.stride, p.fields[j], start, end);
+            else
+                jitc_aos_copy_block<false>(p.aos, p.stride, p.fields[j], start, end);
+        }
+    };
+
+    if (blocks == 1) {
+        callback(0, &payload);
+    } else {
+        // Run on the pool bound via jit_llvm_set_pool()/jit_llvm_set_priority()
+        ThreadState *ts = thread_state_llvm;
+        Task *task = task_submit_dep(ts ? ts->pool : nullptr, nullptr, 0,
+                                     blocks, callback, &payload,
+                                     sizeof(Payload));
+        task_wait_and_release(task);
+    }
+}
+
+/// Check the field layout of jitc_aos_to_soa() / jitc_soa_to_aos()
+static void jitc_aos_check(const char *name, size_t stride,
+                           uint32_t field_count, const VarType *types,
+                           const size_t *offsets) {
+    for (uint32_t j = 0; j < field_count; ++j) {
+        VarType type = types[j];
+        if (unlikely(type == VarType::Void || type == VarType::Pointer ||
+                     (uint32_t) type >= (uint32_t) VarType::Count))
+            jitc_raise("%s(): field %u has an unsupported type!", name, j);
+        if (unlikely(offsets[j] + type_size[(int) type] > stride))
+            jitc_raise("%s(): field %u (offset %zu, size %u) exceeds the "
+                       "record size (%zu bytes)!", name, j, offsets[j],
+                       type_size[(int) type], stride);
+    }
+}
+
+/// Can the fields be accessed via typed views of the AoS buffer?
+static bool jitc_aos_aligned(size_t stride, uint32_t field_count,
+                             const VarType *types, const size_t *offsets) {
+    for (uint32_t j = 0; j < field_count; ++j) {
+        uint32_t isize = type_size[(int) types[j]];
+        if (stride % isize != 0 || offsets[j] % isize != 0)
+            return false;
+    }
+    return true;
+}
+
+/// Index of field 'offset' (in units of 'isize') of every record
+static uint32_t jitc_aos_index(JitBackend backend, uint32_t count,
+                               size_t stride, size_t offset, uint32_t isize) {
+    uint32_t stride_i = (uint32_t) (stride / isize),
+             offset_i = (uint32_t) (offset / isize);
+
+    Ref counter = steal(jitc_var_counter(backend, count, false)),
+        stride_v = steal(jitc_var_literal(backend, VarType::UInt32, &stride_i, 1, 0)),
+        offset_v = steal(jitc_var_literal(backend, VarType::UInt32, &offset_i, 1, 0));
+
+    uint32_t deps_1[2] = { counter, stride_v };
+    Ref scaled = steal(jitc_var_op(JitOp::Mul, deps_1));
+    uint32_t deps_2[2] = { scaled, offset_v };
+    return jitc_var_op(JitOp::Add, deps_2);
+}
+
+void jitc_aos_to_soa(JitBackend backend, const void *src, size_t stride,
+                     uint32_t count, uint32_t field_count,
+                     const VarType *types, const size_t *offsets,
+                     uint32_t *out) {
+    for (uint32_t j = 0; j < field_count; ++j)
+        out[j] = 0;
+    if (count == 0 || field_count == 0)
+        return;
+
+    jitc_aos_check("jit_aos_to_soa", stride, field_count, types, offsets);
+    size_t total_size = stride * (size_t) count;
+
+    if (backend == JitBackend::CUDA &&
+        total_size <= 0xFFFFFFFFu &&
+        jitc_aos_aligned(stride, field_count, types, offsets)) {
+        /* Upload the records and extract the fields with a single kernel
+           that gathers from typed views of the uploaded buffer */
+        Ref raw = steal(jitc_var_mem_copy(backend, AllocType::Host,
+                                          VarType::UInt8, src, total_size));
+        void *raw_ptr = jitc_var(raw)->data;
+        bool value = true;
+        Ref mask = steal(jitc_var_literal(backend, VarType::Bool, &value, 1, 0));
+
+        std::vector<Ref> views;
+        for (uint32_t j = 0; j < field_count; ++j) {
+            uint32_t isize = type_size[(int) types[j]];
+            Ref view = steal(jitc_var_mem_map(backend, types[j], raw_ptr,
+                                              total_size / isize, 0)),
+                index = steal(jitc_aos_index(backend, count, stride,
+                                             offsets[j], isize));
+            out[j] = jitc_var_gather(view, index, mask);
+            jitc_var_schedule(out[j]);
+            views.push_back(std::move(view));
+        }
+
+        jitc_eval(thread_state(backend));
+        return;
+    }
+
+    std::unique_ptr<AosField[]> fields(new AosField[field_count]);
+    for (uint32_t j = 0; j < field_count; ++j) {
+        uint32_t isize = type_size[(int) types[j]];
+        size_t size = (size_t) count * isize;
+
+        // Padding to support out-of-bounds accesses in LLVM gather operations
+        if (backend == JitBackend::LLVM && isize < 4)
+            size += 4 - isize;
+
+        fields[j] = AosField{ (uint8_t *) jitc_malloc(AllocType::Host, size),
+                              offsets[j], isize, isize };
+    }
+
+    /* Release the lock while converting */ {
+        unlock_guard guard(state.lock);
+        jitc_aos_convert(true, (uint8_t *) src, stride, count, field_count,
+                         fields.get());
+    }
+
+    for (uint32_t j = 0; j < field_count; ++j) {
+        if (backend == JitBackend::CUDA) {
+            out[j] = jitc_var_mem_copy(backend, AllocType::Host, types[j],
+                                       fields[j].soa, count);
+            jitc_free(fields[j].soa);
+        } else {
+            void *ptr = jitc_malloc_migrate(fields[j].soa, AllocType::HostAsync, 1);
+            out[j] = jitc_var_mem_map(backend, types[j], ptr, count, 1);
+        }
+    }
+}
+
+uint32_t jitc_soa_to_aos(JitBackend backend, void *dst, size_t stride,
+                         uint32_t field_count, const uint32_t *in,
+                         const size_t *offsets) {
+    uint32_t count = 0;
+    std::unique_ptr<VarType[]> types(new VarType[field_count]);
+
+    for (uint32_t j = 0; j < field_count; ++j) {
+        const Variable *v = jitc_var(in[j]);
+        if (unlikely((JitBackend) v->backend != backend))
+            jitc_raise("jit_soa_to_aos(): variable r%u belongs to a different "
+                       "backend!", in[j]);
+        if (unlikely(count > 1 && v->size > 1 && v->size != count))
+            jitc_raise("jit_soa_to_aos(): arrays have incompatible sizes!");
+        count = std::max(count, v->size);
+        types[j] = (VarType) v->type;
+    }
+
+    if (count == 0)
+        return 0;
+
+    jitc_aos_check("jit_soa_to_aos", stride, field_count, types.get(), offsets);
+    size_t total_size = stride * (size_t) count;
+
+    if (backend == JitBackend::CUDA &&
+        total_size <= 0xFFFFFFFFu &&
+        jitc_aos_aligned(stride, field_count, types.get(), offsets)) {
+        // Scatter all fields into typed views of a device buffer at once
+        void *raw_ptr = jitc_malloc(AllocType::Device, total_size);
+        bool value = true;
+        Ref mask = steal(jitc_var_literal(backend, VarType::Bool, &value, 1, 0));
+
+        std::vector<Ref> views;
+        for (uint32_t j = 0; j < field_count; ++j) {
+            uint32_t isize = type_size[(int) types[j]];
+            Ref view = steal(jitc_var_mem_map(backend, types[j], raw_ptr,
+                                              total_size / isize, 0)),
+                index = steal(jitc_aos_index(backend, count, stride,
+                                             offsets[j], isize));
+            views.push_back(steal(jitc_var_scatter(view, in[j], index, mask,
+                                                   ReduceOp::None)));
+        }
+
+        jitc_eval(thread_state(backend));
+        views.clear();
+        jitc_memcpy(backend, dst, raw_ptr, total_size);
+        jitc_free(raw_ptr);
+        return count;
+    }
+
+    // Fetch the fields (or point to them) and interleave them on the host
+    std::unique_ptr<AosField[]> fields(new AosField[field_count]);
+    std::vector<void *> temp;
+
+    for (uint32_t j = 0; j < field_count; ++j) {
+        jitc_var_eval(in[j]);
+        const Variable *v = jitc_var(in[j]);
+        uint32_t isize = type_size[v->type];
+        uint8_t *ptr;
+
+        if (v->is_literal()) {
+            ptr = (uint8_t *) jitc_malloc(AllocType::Host, sizeof(uint64_t));
+            memcpy(ptr, &v->literal, isize);
+            temp.push_back(ptr);
+        } else if (backend == JitBackend::CUDA) {
+            size_t size = (size_t) v->size * isize;
+            const void *data = v->data;
+            ptr = (uint8_t *) jitc_malloc(AllocType::Host, size);
+            temp.push_back(ptr);
+            jitc_memcpy(backend, ptr, data, size);
+        } else {
+            ptr = (uint8_t *) v->data;
+            Event *event = jitc_event_record(backend, in[j]);
+            jitc_event_wait(event);
+            jitc_event_destroy(event);
+        }
+
+        v = jitc_var(in[j]);
+        fields[j] = AosField{ ptr, offsets[j], isize,
+                              v->size == 1 ? 0u : isize };
+    }
+
+    /* Release the lock while converting */ {
+        unlock_guard guard(state.lock);
+        jitc_aos_convert(false, (uint8_t *) dst, stride, count, field_count,
+                         fields.get());
+    }
+
+    for (void *ptr : temp)
+        jitc_free(ptr);
+
+    return count;
+}
@@ -48,6 +48,13 @@ extern void jitc_memcpy(JitBackend backend, void *dst, const void *src, size_t s
 /// Perform an assynchronous copy operation
 extern void jitc_memcpy_async(JitBackend backend, void *dst, const void *src, size_t size);
 
+/**
+ * \brief Asynchronously duplicate a host-asynchronous allocation of the LLVM
+ * backend, sharing unmodified pages via copy-on-write mappings if possible
+ * (see \ref jitc_cow_copy())
+ */
+extern void jitc_memcpy_async_cow(void *dst, const void *src, size_t size);
+
 /// Replicate individual input elements to larger blocks
 extern void jitc_block_copy(JitBackend backend, enum VarType type, const void *in,
                             void *out, uint32_t size, uint32_t block_size);
@@ -56,6 +63,23 @@ extern void jitc_block_copy(JitBackend backend, enum VarType type, const void *i
 extern void jitc_block_sum(JitBackend backend, enum VarType type, const void *in,
                            void *out, uint32_t size, uint32_t block_size);
 
+/// Sparse matrix-vector product with a matrix in CSR format
+extern void jitc_spmv_csr(JitBackend backend, VarType type,
+                          const uint32_t *offsets, const uint32_t *cols,
+                          const void *values, const void *x, void *out,
+                          uint32_t rows, uint32_t nnz);
+
+/// Extract the fields of an array of records into separate variables
+extern void jitc_aos_to_soa(JitBackend backend, const void *src, size_t stride,
+                            uint32_t count, uint32_t field_count,
+                            const VarType *types, const size_t *offsets,
+                            uint32_t *out);
+
+/// Interleave variables into an array of records, returns the record count
+extern uint32_t jitc_soa_to_aos(JitBackend backend, void *dst, size_t stride,
+                                uint32_t field_count, const uint32_t *in,
+                                const size_t *offsets);
+
 /// Asynchronously update a single element in memory
 extern void jitc_poke(JitBackend backend, void *dst, const void *src, uint32_t size);
 
@@ -14,6 +14,8 @@
 #include "util.h"
 #include "op.h"
 #include "registry.h"
+#include "event.h"
+#include "cow.h"
 
 // When debugging via valgrind, this will make iterator invalidation more obvious
 // #define DRJIT_VALGRIND 1
@@ -169,7 +171,13 @@ const char *var_kind_name[(int) VarKind::Count] {
     "trace_ray",
 
     // Extract a component from an operation that produced multiple results
-    "extract"
+    "extract",
+
+    // Call a function of a module registered via jit_llvm_register_module()
+    "ext_call",
+
+    // Per-lane product with a shared matrix (LLVM)
+    "matvec"
 };
 
 
@@ -410,6 +418,7 @@ void jitc_value_print(const Variable *v, bool graphviz = false) {
         break;
 
     switch ((VarType) v->type) {
+        case VarType::Float16: var_buffer.fmt("%g", jitc_half_to_float((uint16_t) v->literal)); break;
         case VarType::Float32: JIT_LITERAL_PRINT(float, float, "%g");
         case VarType::Float64: JIT_LITERAL_PRINT(double, double, "%g");
         case VarType::Bool:    JIT_LITERAL_PRINT(bool, int, "%i");
@@ -603,10 +612,11 @@ uint32_t jitc_var_pointer(JitBackend backend, const void *value,
 
     // Write pointers create a special type of reference to indicate pending writes
     v.write_ptr = write != 0;
-    if (write)
+    if (write) {
         jitc_var_inc_ref_se(dep);
-    else
+    } else {
         jitc_var_inc_ref(dep);
+    }
 
     return jitc_var_new(v);
 }
@@ -976,6 +986,7 @@ const char *jitc_var_str(uint32_t index) {
             case VarType::UInt32:  var_buffer.fmt("%"   PRIu32 "%s", *((uint32_t *) dst), comma); break;
             case VarType::Int64:   var_buffer.fmt("%"   PRId64 "%s", *(( int64_t *) dst), comma); break;
             case VarType::UInt64:  var_buffer.fmt("%"   PRIu64 "%s", *((uint64_t *) dst), comma); break;
+            case VarType::Float16: var_buffer.fmt("%g%s", jitc_half_to_float(*((uint16_t *) dst)), comma); break;
             case VarType::Float32: var_buffer.fmt("%g%s", *((float *) dst), comma); break;
             case VarType::Float64: var_buffer.fmt("%g%s", *((double *) dst), comma); break;
             default: jitc_fail("jit_var_str(): unsupported type!");
@@ -1131,9 +1142,130 @@ uint32_t jitc_var_write(uint32_t index, size_t offset, const void *src) {
     uint8_t *dst = (uint8_t *) v->data + offset * isize;
     jitc_poke((JitBackend) v->backend, dst, src, isize);
 
+    // The write is ordered after the kernel that originally produced 'v'
+    v->eval_id = 0;
+
     return index;
 }
 
+/// Check the offsets of a batched read/write and convert them to 32 bit
+static std::vector<uint32_t> jitc_var_offsets(const char *name, uint32_t size,
+                                              const size_t *offsets,
+                                              uint32_t count) {
+    std::vector<uint32_t> result(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        size_t offset = size == 1 ? 0 : offsets[i];
+        if (unlikely(offset >= (size_t) size))
+            jitc_raise("%s(): attempted to access entry %zu in an array of "
+                       "size %u!", name, offset, size);
+        result[i] = (uint32_t) offset;
+    }
+    return result;
+}
+
+template <typename T>
+static void jitc_var_read_many_impl(const uint8_t *src, const uint32_t *offsets,
+                                    uint32_t count, uint8_t *dst) {
+    for (uint32_t i = 0; i < count; ++i)
+        memcpy(dst + i * sizeof(T), src + offsets[i] * sizeof(T), sizeof(T));
+}
+
+/// Read multiple elements of a variable and write them to 'dst' (async.)
+Event *jitc_var_read_many_async(uint32_t index, const size_t *offsets,
+                                uint32_t count, void *dst) {
+    jitc_var_eval(index);
+
+    const Variable *v = jitc_var(index);
+    JitBackend backend = (JitBackend) v->backend;
+    uint32_t isize = type_size[v->type];
+    std::vector<uint32_t> offsets_32 =
+        jitc_var_offsets("jit_var_read_many", v->size, offsets, count);
+
+    if (v->is_literal() || count == 0) {
+        for (uint32_t i = 0; i < count; ++i)
+            memcpy((uint8_t *) dst + i * isize, &v->literal, isize);
+        return jitc_event_record(backend, 0);
+    }
+
+    if (backend == JitBackend::CUDA) {
+        // Gather the requested entries on the device and fetch them at once
+        Ref index_v = steal(jitc_var_mem_copy(backend, AllocType::Host,
+                                              VarType::UInt32,
+                                              offsets_32.data(), count));
+        bool value = true;
+        Ref mask = steal(jitc_var_literal(backend, VarType::Bool, &value, 1, 0));
+        Ref gather = steal(jitc_var_gather(index, index_v, mask));
+        jitc_var_eval(gather);
+        jitc_memcpy_async(backend, dst, jitc_var(gather)->data,
+                          (size_t) count * isize);
+        return jitc_event_record(backend, 0);
+    }
+
+    struct Payload {
+        const uint8_t *src;
+        uint8_t *dst;
+        uint32_t isize, count;
+        uint32_t offsets[1];
+    };
+
+    Payload *p = (Payload *) malloc_check(sizeof(Payload) +
+                                          (count - 1) * sizeof(uint32_t));
+    p->src = (const uint8_t *) v->data;
+    p->dst = (uint8_t *) dst;
+    p->isize = isize;
+    p->count = count;
+    memcpy(p->offsets, offsets_32.data(), count * sizeof(uint32_t));
+
+    return jitc_event_enqueue(
+        thread_state(backend), &index, 1, false,
+        [](void *payload) {
+            Payload *p2 = (Payload *) payload;
+            switch (p2->isize) {
+                case 1: jitc_var_read_many_impl<uint8_t>(p2->src, p2->offsets, p2->count, p2->dst); break;
+                case 2: jitc_var_read_many_impl<uint16_t>(p2->src, p2->offsets, p2->count, p2->dst); break;
+                case 4: jitc_var_read_many_impl<uint32_t>(p2->src, p2->offsets, p2->count, p2->dst); break;
+                case 8: jitc_var_read_many_impl<uint64_t>(p2->src, p2->offsets, p2->count, p2->dst); break;
+            }
+            free(p2);
+        },
+        p);
+}
+
+/// Read multiple elements of a variable and write them to 'dst'
+void jitc_var_read_many(uint32_t index, const size_t *offsets, uint32_t count,
+                        void *dst) {
+    Event *event = jitc_var_read_many_async(index, offsets, count, dst);
+    jitc_event_wait(event);
+    jitc_event_destroy(event);
+}
+
+/// Copy 'src' to multiple elements of a variable using a single scatter
+uint32_t jitc_var_write_many(uint32_t index, const size_t *offsets,
+                             uint32_t count, const void *src) {
+    const Variable *v = jitc_var(index);
+    JitBackend backend = (JitBackend) v->backend;
+    VarType type = (VarType) v->type;
+
+    if (count == 0) {
+        jitc_var_inc_ref(index);
+        return index;
+    }
+
+    std::vector<uint32_t> offsets_32 =
+        jitc_var_offsets("jit_var_write_many", v->size, offsets, count);
+
+    Ref index_v = steal(jitc_var_mem_copy(backend, AllocType::Host,
+                                          VarType::UInt32, offsets_32.data(),
+                                          count)),
+        value_v = steal(jitc_var_mem_copy(backend, AllocType::Host, type, src,
+                                          count));
+
+    bool value = true;
+    Ref mask = steal(jitc_var_literal(backend, VarType::Bool, &value, 1, 0));
+
+    return jitc_var_scatter(index, value_v, index_v, mask, ReduceOp::None);
+}
+
 /// Register an existing variable with the JIT compiler
 uint32_t jitc_var_mem_map(JitBackend backend, VarType type, void *ptr,
                           size_t size, int free) {
@@ -1234,8 +1366,30 @@ uint32_t jitc_var_copy(uint32_t index) {
         JitBackend backend = (JitBackend) v->backend;
         AllocType atype = backend == JitBackend::CUDA ? AllocType::Device
                                                       : AllocType::HostAsync;
-        result = jitc_var_mem_copy(backend, atype, (VarType) v->type, v->data,
-                                   v->size);
+        size_t size = (size_t) v->size * type_size[v->type];
+
+        bool cow = false;
+        if (backend == JitBackend::LLVM && size >= DRJIT_COW_THRESHOLD) {
+            auto it = state.alloc_used.find((uintptr_t) v->data);
+            if (it != state.alloc_used.end()) {
+                auto [size_2, atype_2, device_2] = alloc_info_decode(it->second);
+                cow = atype_2 == AllocType::HostAsync;
+                (void) size_2; (void) device_2;
+            }
+        }
+
+        if (cow) {
+            /* Large buffer allocated by Dr.Jit: only duplicate the pages
+               that are subsequently modified (see cow.h) */
+            void *data = jitc_malloc(atype, size);
+            v = jitc_var(index);
+            jitc_memcpy_async_cow(data, v->data, size);
+            result = jitc_var_mem_map(backend, (VarType) v->type, data,
+                                      v->size, 1);
+        } else {
+            result = jitc_var_mem_copy(backend, atype, (VarType) v->type,
+                                       v->data, v->size);
+        }
     } else {
         Variable v2;
         v2.type = v->type;
@@ -15,6 +15,7 @@
 enum VarKind : uint32_t;
 
 struct Variable;
+struct Event;
 
 /// Look up a variable by its ID
 extern Variable *jitc_var(uint32_t index);
@@ -78,6 +79,18 @@ extern uint32_t jitc_var_mem_copy(JitBackend backend, AllocType atype,
                                   VarType vtype, const void *ptr,
                                   size_t size);
 
+/// Read multiple elements of a variable and write them to 'dst'
+extern void jitc_var_read_many(uint32_t index, const size_t *offsets,
+                               uint32_t count, void *dst);
+
+/// Asynchronous version of \ref jitc_var_read_many()
+extern Event *jitc_var_read_many_async(uint32_t index, const size_t *offsets,
+                                       uint32_t count, void *dst);
+
+/// Copy 'src' to multiple elements of a variable
+extern uint32_t jitc_var_write_many(uint32_t index, const size_t *offsets,
+                                    uint32_t count, const void *src);
+
 /// Duplicate a variable
 extern uint32_t jitc_var_copy(uint32_t index);
 
@@ -16,12 +16,16 @@
 #include "op.h"
 #include "profiler.h"
 #include "vcall.h"
+#include "llvm_pool.h"
 #include <set>
 
 using CallablesSet = std::set<XXH128_hash_t, XXH128Cmp>;
 
 static std::vector<VCall *> vcalls_assembled;
 
+/// Dominant instance per domain, as observed by jitc_var_vcall_reduce()
+static tsl::robin_map<std::string, uint32_t> vcall_profile;
+
 static void jitc_var_vcall_collect_data(
     tsl::robin_map<uint64_t, uint32_t, UInt64Hasher> &data_map,
     uint32_t &data_offset, uint32_t inst_id, uint32_t index,
@@ -190,6 +194,13 @@ uint32_t jitc_var_vcall(const char *name, uint32_t self, uint32_t mask_,
     vcall->backend = backend;
     vcall->name = strdup(name);
     vcall->n_inst = n_inst;
+
+    if (backend == JitBackend::LLVM && n_inst > 1 &&
+        jit_flag(JitFlag::VCallOptimize)) {
+        auto it = vcall_profile.find(name);
+        if (it != vcall_profile.end())
+            vcall->hot_inst = it->second;
+    }
     vcall->inst_id = std::vector<uint32_t>(inst_id, inst_id + n_inst);
     vcall->inst_hash.resize(n_inst);
     vcall->in.reserve(n_in);
@@ -782,12 +793,13 @@ void jitc_vcall_upload(ThreadState *ts) {
         if (vcall->backend == JitBackend::CUDA) {
             jitc_free(data);
         } else {
+            Task *&task_head = jitc_task_head(ts);
             Task *new_task = task_submit_dep(
-                nullptr, &jitc_task, 1, 1,
+                ts->pool, &task_head, 1, 1,
                 [](uint32_t, void *payload) { jit_free(*((void **) payload)); },
                 &data, sizeof(void *), nullptr, 1);
-            task_release(jitc_task);
-            jitc_task = new_task;
+            task_release(task_head);
+            task_head = new_task;
         }
     }
 
@@ -796,6 +808,10 @@ void jitc_vcall_upload(ThreadState *ts) {
     vcalls_assembled.clear();
 }
 
+void jitc_vcall_profile_clear() {
+    vcall_profile.clear();
+}
+
 // Compute a permutation to reorder an array of registered pointers
 VCallBucket *jitc_var_vcall_reduce(JitBackend backend, const char *domain,
                                    uint32_t index, uint32_t *bucket_count_out) {
@@ -871,6 +887,34 @@ VCallBucket *jitc_var_vcall_reduce(JitBackend backend, const char *domain,
         }
     );
 
+    /* Remember if a single instance dominates the non-masked lanes. Later
+       calls in this domain then handle it via a guarded direct call. */
+    if (domain && backend == JitBackend::LLVM) {
+        uint32_t hot_id = 0, hot_size = 0;
+        uint64_t active_size = 0;
+        for (uint32_t i = 0; i < unique_count; ++i) {
+            const InputBucket &bucket = input_buckets[i];
+            if (bucket.id == 0)
+                continue;
+            if (!hot_id) {
+                hot_id = bucket.id;
+                hot_size = bucket.size;
+            }
+            active_size += bucket.size;
+        }
+
+        if (hot_id && (uint64_t) hot_size * 100 >=
+                          active_size * DRJIT_VCALL_HOT_RATIO) {
+            jitc_log(Debug,
+                     "jit_var_vcall_reduce(): instance %u of domain \"%s\" "
+                     "covers %u/%llu lanes.", hot_id, domain, hot_size,
+                     (unsigned long long) active_size);
+            vcall_profile[domain] = hot_id;
+        } else {
+            vcall_profile.erase(domain);
+        }
+    }
+
     for (uint32_t i = 0; i < unique_count; ++i) {
         InputBucket bucket = input_buckets[i];
 
@@ -1,6 +1,13 @@
 #include "internal.h"
 #include <stdint.h>
 
+/**
+ * Minimum share (in percent) of the non-masked lanes that must reference a
+ * single instance in \ref jitc_var_vcall_reduce() so that later calls with the
+ * same name are devirtualized for this instance in LLVM mode
+ */
+#define DRJIT_VCALL_HOT_RATIO 90
+
 extern void jitc_vcall_set_self(JitBackend backend, uint32_t value, uint32_t index);
 extern void jitc_vcall_self(JitBackend backend, uint32_t *value, uint32_t *index);
 
@@ -19,6 +26,9 @@ extern VCallBucket *jitc_var_vcall_reduce(JitBackend backend,
                                           const char *domain, uint32_t index,
                                           uint32_t *bucket_count_out);
 
+/// Forget the instance profiles gathered by \ref jitc_var_vcall_reduce()
+extern void jitc_vcall_profile_clear();
+
 /// Helper data structure used to initialize the data block consumed by a vcall
 struct VCallDataRecord {
     uint32_t offset;
@@ -75,6 +85,9 @@ struct VCall {
     /// Does this vcall need self as argument
     bool use_self = false;
 
+    /// Instance that was observed to dominate this call site (or zero)
+    uint32_t hot_inst = 0;
+
     ~VCall() {
         for (uint32_t index : out_nested)
             jitc_var_dec_ref(index);
@@ -3,10 +3,17 @@
 #endif
 
 #include "test.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include <initializer_list>
 #include <cmath>
 #include <cstring>
 #include <typeinfo>
+#include <vector>
+#include <string>
+
+extern std::string log_value;
 
 TEST_BOTH(01_creation_destruction_cse) {
     // Test CSE involving normal and evaluated constant literals
@@ -646,3 +653,530 @@ TEST_BOTH(08_printf) {
     jit_eval();
 }
 #endif
+
+TEST_LLVM(09_priority) {
+    jit_assert(jit_llvm_priority() == JitPriority::Normal);
+
+    // Compile the latency-critical kernel ahead of time
+    auto small = [](uint32_t i) {
+        UInt32 y = arange<UInt32>(100) + i;
+        return y.read(99) == 99 + i;
+    };
+    jit_assert(small(0));
+
+    /* Background job on a separate thread with its own low-priority queue,
+       which receives a long chain of kernels without waiting for them */
+    std::atomic<void *> event { nullptr };
+    std::atomic<bool> done { false };
+    std::thread background([&] {
+        jit_llvm_set_priority(JitPriority::Low);
+        UInt32 x = arange<UInt32>(1u << 23);
+        for (uint32_t i = 0; i < 32; ++i) {
+            x = x * 3u + 1u;
+            x.eval();
+        }
+        event = jit_event_record(Backend, 0);
+        while (!done)
+            std::this_thread::yield();
+        jit_event_wait(event);
+        jit_event_destroy(event);
+
+        uint32_t ref = 5;
+        for (uint32_t i = 0; i < 32; ++i)
+            ref = ref * 3u + 1u;
+        jit_assert(x.read(5) == ref);
+        jit_llvm_set_priority(JitPriority::Normal);
+    });
+
+    while (!event)
+        std::this_thread::yield();
+
+    /* High-priority work completes while the background work is still
+       pending, rather than being queued behind it */
+    jit_llvm_set_priority(JitPriority::High);
+    jit_assert(jit_llvm_priority() == JitPriority::High);
+    for (uint32_t i = 0; i < 10; ++i)
+        jit_assert(small(i));
+    jit_assert(!jit_event_query(event));
+    jit_llvm_set_priority(JitPriority::Normal);
+
+    done = true;
+    background.join();
+}
+
+TEST_LLVM(10_pool) {
+    uint32_t pool = jit_llvm_pool_create(2);
+    jit_assert(pool != 0 && jit_llvm_pool() == 0);
+
+    LLVMPoolStats stats_default_before, stats_default, stats;
+    jit_llvm_pool_stats(0, &stats_default_before);
+
+    // Two kernels with 4 work units each (DRJIT_POOL_BLOCK_SIZE == 16384)
+    std::thread tenant([pool] {
+        jit_llvm_set_pool(pool);
+        jit_assert(jit_llvm_pool() == pool);
+        UInt32 x = arange<UInt32>(1u << 16) + 5u;
+        x.eval();
+        UInt32 y = x * 2u;
+        y.eval();
+        jit_assert(x.read(1000) == 1005u && y.read(1000) == 2010u);
+        jit_llvm_set_pool(0);
+    });
+    tenant.join();
+
+    jit_llvm_pool_stats(pool, &stats);
+    jit_assert(stats.thread_count == 2 && stats.bound_count == 0);
+    jit_assert(stats.launches == 2 && stats.work_units == 8);
+    jit_assert(stats.utilization >= 0.0 && stats.utilization <= 1.0);
+
+    // The work of the tenant was not accounted to the default pool
+    jit_llvm_pool_stats(0, &stats_default);
+    jit_assert(stats_default.launches == stats_default_before.launches);
+    jit_assert(stats_default.work_units == stats_default_before.work_units);
+
+    jit_llvm_pool_destroy(pool);
+}
+
+TEST_LLVM(11_cancel) {
+    // Work units starting after the deadline are skipped
+    jit_llvm_set_deadline(1e-3f);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+    UInt32 x = arange<UInt32>(1u << 20) * 2u;
+    x.eval();
+
+    bool raised = false;
+    try {
+        jit_sync_thread();
+    } catch (const std::exception &) {
+        raised = true;
+    }
+    jit_assert(raised);
+    jit_llvm_set_deadline(0.f);
+
+    // Cancellation only affects kernels that were launched before it
+    jit_llvm_cancel(jit_llvm_cancel_token());
+    UInt32 y = arange<UInt32>(1000) * 2u;
+    jit_assert(y.read(999) == 1998u);
+}
+
+TEST_BOTH(12_events) {
+    UInt32 x = arange<UInt32>(1u << 16) * 3u;
+    jit_assert(jit_var_ready(x.index()) == 0);
+
+    void *event = jit_event_record(Backend, x.index());
+    jit_assert(jit_var_is_evaluated(x.index()));
+    jit_event_wait(event);
+    jit_assert(jit_event_query(event) == 1);
+    jit_assert(jit_var_ready(x.index()) == 1);
+    jit_event_destroy(event);
+
+    // Events can also track all work submitted by the calling thread
+    UInt32 y = x + 1u;
+    y.eval();
+    event = jit_event_record(Backend);
+    jit_event_wait(event);
+    jit_event_destroy(event);
+    jit_assert(y.read(1000) == 3001u);
+}
+
+TEST_BOTH(13_read_write_many) {
+    UInt32 x = arange<UInt32>(1000) * 2u;
+
+    size_t offsets[] = { 999, 0, 17, 500, 17 };
+    uint32_t values[5];
+    jit_var_read_many(x.index(), offsets, 5, values);
+    for (uint32_t i = 0; i < 5; ++i)
+        jit_assert(values[i] == (uint32_t) offsets[i] * 2u);
+
+    uint32_t new_values[] = { 1, 2, 3 };
+    UInt32 y = UInt32::steal(jit_var_write_many(x.index(), offsets, 3, new_values));
+    void *event = jit_var_read_many_async(y.index(), offsets, 4, values);
+    jit_event_wait(event);
+    jit_event_destroy(event);
+    jit_assert(values[0] == 1 && values[1] == 2 && values[2] == 3 &&
+               values[3] == 1000);
+}
+
+TEST_LLVM(14_host_func) {
+    struct Payload {
+        const uint32_t *data;
+        uint32_t value;
+    };
+
+    UInt32 x = arange<UInt32>(1000) + 5u;
+    uint32_t index = x.index();
+    x.eval();
+
+    Payload payload { (const uint32_t *) jit_var_ptr(index), 0 };
+    jit_enqueue_host_func(
+        Backend,
+        [](void *p) {
+            Payload *p2 = (Payload *) p;
+            p2->value = p2->data[10];
+        },
+        &payload, &index, 1);
+
+    jit_sync_thread();
+    jit_assert(payload.value == 15u);
+}
+
+#if !defined(_WIN32)
+TEST_LLVM(15_kernel_pack) {
+    const char *path = "kernel_pack.bin";
+
+    jit_flush_kernel_cache();
+    UInt32 x = arange<UInt32>(1000) * 3u + 2u;
+    x.eval();
+    uint32_t count = jit_kernel_pack_write(path);
+    jit_assert(count > 0);
+
+    // Kernels can now be loaded from the pack instead of being recompiled
+    jit_kernel_pack_load(path);
+    jit_flush_kernel_cache();
+    log_value.clear();
+    UInt32 y = arange<UInt32>(1000) * 3u + 2u;
+    jit_assert(all(eq(x, y)));
+    jit_assert(log_value.find("found in kernel pack") != std::string::npos);
+
+    // Damage the kernel data, the cache directory is used as a fallback
+    FILE *f = fopen(path, "r+b");
+    jit_assert(f);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f), offset = 12 + 32 * (long) count; // header + table
+    jit_assert(size > offset);
+    std::vector<uint8_t> junk((size_t) (size - offset), 0xFF);
+    fseek(f, offset, SEEK_SET);
+    fwrite(junk.data(), 1, junk.size(), f);
+    fclose(f);
+
+    jit_kernel_pack_load(path);
+    jit_flush_kernel_cache();
+    log_value.clear();
+    UInt32 z = arange<UInt32>(1000) * 3u + 2u;
+    jit_assert(all(eq(x, z)));
+    jit_assert(log_value.find("falling back to the cache directory") !=
+               std::string::npos);
+    jit_assert(log_value.find("found in kernel pack") == std::string::npos);
+
+    jit_kernel_pack_load(nullptr);
+    remove(path);
+}
+#endif
+
+#if defined(DRJIT_DYNAMIC_CUDA) && !defined(_WIN32)
+TEST_LLVM(16_cuda_virtual_device) {
+    if (jit_has_backend(JitBackend::CUDA))
+        return;
+
+    // Generate PTX code for a device that isn't present in this machine
+    jit_cuda_set_virtual_device(71, 86);
+    jit_init((uint32_t) JitBackend::CUDA);
+    jit_assert(jit_has_backend(JitBackend::CUDA));
+    jit_assert(jit_cuda_compute_capability() == 86);
+
+    jit_set_flag(JitFlag::KernelHistory, 1);
+    jit_kernel_history_clear();
+
+    /* Scope */ {
+        FloatC x = linspace<FloatC>(0.f, 1.f, 1000);
+        UInt32C y = UInt32C(x * 5.f) + arange<UInt32C>(1000);
+        y.eval();
+    }
+
+    KernelHistoryEntry *data = jit_kernel_history();
+    jit_set_flag(JitFlag::KernelHistory, 0);
+    jit_assert(data && data[0].backend == JitBackend::CUDA);
+
+    // The PTX code targets the virtual device
+    for (KernelHistoryEntry *e = data; e->backend != (JitBackend) 0; ++e) {
+        if (e->type == KernelType::JIT)
+            jit_assert(strstr(e->ir, ".target sm_86") != nullptr);
+        free(e->ir);
+    }
+    free(data);
+
+    const char *path = "kernel_pack_virtual.bin";
+    jit_assert(jit_kernel_pack_write(path) > 0);
+    remove(path);
+
+    jit_shutdown(0);
+    jit_cuda_set_virtual_device(0, 0);
+    jit_init((uint32_t) JitBackend::LLVM);
+}
+#endif
+
+TEST_LLVM(17_float16) {
+    // 1, 2, 3, -4, 0.5 in half precision
+    uint16_t in[5] = { 0x3c00, 0x4000, 0x4200, 0xc400, 0x3800 };
+    uint32_t x = jit_var_mem_copy(Backend, AllocType::Host, VarType::Float16, in, 5),
+             y = jit_var_mul(x, x),
+             z = jit_var_fma(x, y, x);
+
+    jit_assert(strcmp(jit_var_str(y), "[1, 4, 9, 16, 0.25]") == 0);
+    jit_assert(strcmp(jit_var_str(z), "[2, 10, 30, -68, 0.625]") == 0);
+
+    // Arrays remain in 16 bit form in memory
+    uint16_t out[5];
+    jit_var_read(z, 4, out);
+    jit_assert(out[4] == 0x3900);
+
+    // Literals, casts, and gathers
+    uint16_t half_one = 0x3c00;
+    uint32_t one = jit_var_literal(Backend, VarType::Float16, &half_one, 1),
+             w = jit_var_sub(z, one),
+             w_f32 = jit_var_cast(w, VarType::Float32, 0);
+    Float w2 = Float::steal(w_f32);
+    jit_assert(all(eq(w2, Float(1.f, 9.f, 29.f, -69.f, -0.375f))));
+
+    UInt32 idx(4, 0);
+    uint32_t g = jit_var_gather(w, idx.index(), Mask(true).index());
+    jit_assert(strcmp(jit_var_str(g), "[-0.375, 1]") == 0);
+
+    for (uint32_t i : { x, y, z, one, w, g })
+        jit_var_dec_ref(i);
+}
+
+TEST_LLVM(18_llvm_call) {
+    // Register a module computing '2*a + b' for the current vector width
+    uint32_t w = jit_llvm_vector_width();
+    char ir[512];
+    snprintf(ir, sizeof(ir),
+             "define <%u x float> @drjit_test_axpy(<%u x float> %%a, <%u x float> %%b) {\n"
+             "    %%1 = fadd <%u x float> %%a, %%a\n"
+             "    %%2 = fadd <%u x float> %%1, %%b\n"
+             "    ret <%u x float> %%2\n"
+             "}\n", w, w, w, w, w, w);
+    jit_llvm_register_module(ir, strlen(ir));
+
+    Float a = arange<Float>(10), b(1.f);
+    uint32_t args[2] = { a.index(), b.index() };
+    Float c = Float::steal(jit_llvm_call("drjit_test_axpy", VarType::Float32, 2, args));
+    jit_assert(strcmp(c.str(), "[1, 3, 5, 7, 9, 11, 13, 15, 17, 19]") == 0);
+
+    // The result can be used by further traced computation
+    Float d = c + a;
+    jit_assert(strcmp(d.str(), "[1, 4, 7, 10, 13, 16, 19, 22, 25, 28]") == 0);
+
+    // Calls that don't match the signature of the callee are rejected
+    UInt32 e = arange<UInt32>(10);
+    uint32_t args_2[2] = { a.index(), e.index() };
+    for (int i = 0; i < 2; ++i) {
+        bool raised = false;
+        try {
+            jit_var_dec_ref(i == 0 ? jit_llvm_call("drjit_test_axpy",
+                                                   VarType::Float32, 2, args_2)
+                                   : jit_llvm_call("drjit_test_axpy",
+                                                   VarType::Float64, 2, args));
+        } catch (const std::exception &) {
+            raised = true;
+        }
+        jit_assert(raised);
+    }
+}
+
+TEST_LLVM(19_matvec) {
+    // Two-layer perceptron with 3 inputs, 4 hidden units, and 2 outputs
+    float w1_data[12] = { 1, 0, 0,  0, 1, 0,  0, 0, 1,  1, -1, 1 },
+          b1_data[4]  = { 0, 0, 0, -10 },
+          w2_data[8]  = { 1, 1, 1, 1,  0.5f, 0, 0, 2 };
+
+    Float w1 = Float::copy(w1_data, 12),
+          b1 = Float::copy(b1_data, 4),
+          w2 = Float::copy(w2_data, 8);
+
+    Float x = arange<Float>(5), y = x * 2.f, z(1.f);
+    uint32_t in[3] = { x.index(), y.index(), z.index() }, hidden[4], out[2];
+
+    jit_llvm_matvec(w1.index(), b1.index(), 4, 3, in, hidden);
+
+    // ReLU activation
+    Float act[4];
+    uint32_t act_idx[4];
+    for (uint32_t i = 0; i < 4; ++i) {
+        act[i] = max(Float::steal(hidden[i]), Float(0.f));
+        act_idx[i] = act[i].index();
+    }
+
+    jit_llvm_matvec(w2.index(), 0, 2, 4, act_idx, out);
+
+    Float o0 = Float::steal(out[0]), o1 = Float::steal(out[1]);
+    jit_assert(strcmp(o0.str(), "[1, 4, 7, 10, 13]") == 0);
+    jit_assert(strcmp(o1.str(), "[0, 0.5, 1, 1.5, 2]") == 0);
+}
+
+TEST_BOTH(20_roofline) {
+    Float x = arange<Float>(1000), y = x * 2.f;
+    jit_var_eval(x.index());
+    jit_var_eval(y.index());
+
+    jit_set_flag(JitFlag::KernelHistory, 1);
+    jit_kernel_history_clear();
+
+    Float z = fmadd(x, y, Float(1.f));
+    jit_var_eval(z.index());
+    Int32 w = Int32(z);
+    jit_var_eval(w.index());
+
+    KernelHistoryEntry *data = jit_kernel_history();
+    jit_set_flag(JitFlag::KernelHistory, 0);
+    jit_assert(data && data[0].type == KernelType::JIT &&
+               data[1].type == KernelType::JIT);
+
+    // Two inputs and one output, one FMA per lane
+    const KernelHistoryEntry &e = data[0];
+    jit_assert(e.bytes_read == 8000 && e.bytes_written == 4000);
+    jit_assert(e.arithmetic_ops == 2000);
+    jit_assert(e.arithmetic_intensity > 0.16f && e.arithmetic_intensity < 0.17f);
+
+    // Casts only move data
+    jit_assert(data[1].bytes_read == 4000 && data[1].bytes_written == 4000 &&
+               data[1].arithmetic_ops == 0);
+
+    for (KernelHistoryEntry *e2 = data; e2->backend != (JitBackend) 0; ++e2)
+        free(e2->ir);
+    free(data);
+}
+
+TEST_LLVM(21_uniform_gather) {
+    Float src = arange<Float>(16) * 3.f;
+    UInt32 offset = arange<UInt32>(1) + 5u;
+    jit_var_eval(src.index());
+    jit_var_eval(offset.index());
+
+    jit_set_flag(JitFlag::KernelHistory, 1);
+    jit_kernel_history_clear();
+
+    // Both gathers load from a single address shared by all lanes
+    UInt32 idx = offset + 2u;
+    Float y = gather(src, idx) * 2.f + arange<Float>(4),
+          z = gather(src, idx, idx > 100u) + arange<Float>(4);
+    jit_var_schedule(y.index());
+    jit_var_schedule(z.index());
+    jit_eval();
+
+    KernelHistoryEntry *data = jit_kernel_history();
+    jit_set_flag(JitFlag::KernelHistory, 0);
+    jit_assert(data && data[0].type == KernelType::JIT);
+    jit_assert(strstr(data[0].ir, "llvm.masked.gather") == nullptr);
+
+    jit_assert(strcmp(y.str(), "[42, 43, 44, 45]") == 0);
+    jit_assert(strcmp(z.str(), "[0, 1, 2, 3]") == 0);
+
+    for (KernelHistoryEntry *e = data; e->backend != (JitBackend) 0; ++e)
+        free(e->ir);
+    free(data);
+}
+
+TEST_LLVM(22_cancel_running) {
+    // Launch a long-running kernel, optionally cancel it, and wait for it
+    auto run = [](bool cancel, bool *raised) {
+        Float x = arange<Float>(1u << 24);
+        for (int i = 0; i < 100; ++i)
+            x = sqrt(fmadd(x, x, Float(1.f)));
+
+        auto t0 = std::chrono::steady_clock::now();
+        x.eval();
+        if (cancel)
+            jit_llvm_cancel(jit_llvm_cancel_token());
+
+        *raised = false;
+        try {
+            jit_sync_thread();
+        } catch (const std::exception &) {
+            *raised = true;
+        }
+
+        return std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - t0).count();
+    };
+
+    bool raised_full, raised_cancel;
+    run(false, &raised_full); // Compile the kernel
+    double time_full = run(false, &raised_full),
+           time_cancel = run(true, &raised_cancel);
+
+    // The sync raises, and the pool was freed up before finishing the kernel
+    jit_assert(!raised_full && raised_cancel);
+    jit_assert(time_cancel < time_full * .5);
+
+    // Subsequent reads are unaffected
+    UInt32 y = arange<UInt32>(1000) * 2u;
+    jit_assert(y.read(999) == 1998u);
+}
+
+TEST_LLVM(23_read_many_no_drain) {
+    UInt32 x = arange<UInt32>(1000) * 2u;
+    x.eval();
+
+    // Block the queue with a host callback until the read has finished
+    struct Payload {
+        std::atomic<bool> release { false }, done { false };
+    } payload;
+
+    jit_enqueue_host_func(
+        Backend,
+        [](void *p) {
+            Payload *p2 = (Payload *) p;
+            auto deadline = std::chrono::steady_clock::now() +
+                            std::chrono::seconds(5);
+            while (!p2->release && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::yield();
+            p2->done = true;
+        },
+        &payload, nullptr, 0);
+
+    // Only waits for the kernel that produced 'x'
+    size_t offsets[] = { 999, 3 };
+    uint32_t values[2];
+    jit_var_read_many(x.index(), offsets, 2, values);
+    jit_assert(!payload.done);
+    payload.release = true;
+
+    jit_assert(values[0] == 1998u && values[1] == 6u);
+    jit_sync_thread();
+    jit_assert(payload.done);
+}
+
+TEST_LLVM(24_event_independent_queues) {
+    uint32_t pool = jit_llvm_pool_create(2);
+    // Compile the short kernel ahead of time
+    (arange<UInt32>(1000) * 2u + 1u).eval();
+    jit_sync_thread();
+
+    /* A tenant thread with a separate pool (and hence its own task queue)
+       submits a long chain of kernels without waiting for them */
+    std::atomic<void *> event_long { nullptr };
+    std::atomic<bool> done { false };
+    std::thread tenant([&] {
+        jit_llvm_set_pool(pool);
+        UInt32 x = arange<UInt32>(1u << 23);
+        for (uint32_t i = 0; i < 32; ++i) {
+            x = x * 3u + 1u;
+            x.eval();
+        }
+        event_long = jit_event_record(Backend, x.index());
+        while (!done)
+            std::this_thread::yield();
+        jit_event_wait(event_long);
+        jit_assert(jit_event_query(event_long) == 1);
+        jit_event_destroy(event_long);
+        jit_llvm_set_pool(0);
+    });
+
+    while (!event_long)
+        std::this_thread::yield();
+
+    // The short kernel runs alongside the long chain instead of after it
+    UInt32 z = arange<UInt32>(1000) * 2u + 1u;
+    void *event_short = jit_event_record(Backend, z.index());
+    jit_event_wait(event_short);
+    jit_assert(jit_event_query(event_short) == 1);
+    jit_assert(jit_event_query(event_long) == 0);
+    jit_event_destroy(event_short);
+
+    done = true;
+    tenant.join();
+    jit_assert(z.read(999) == 1999u);
+    jit_llvm_pool_destroy(pool);
+}
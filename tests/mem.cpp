@@ -1,5 +1,10 @@
 #include "test.h"
 #include <cstring>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+extern std::string log_value;
 
 TEST_BOTH(01_gather) {
     Int32 r = arange<Int32>(100) + 100;
@@ -213,3 +218,378 @@ TEST_LLVM(14_gather_symbolic_llvm_mask) {
     Float buf_3 = gather<Float>(buf_2, arange<UInt32>(4, 8, 1));
     jit_assert(strcmp(buf_3.str(), "[5, 6, 7, 8]") == 0);
 }
+
+TEST_LLVM(15_numa_affinity) {
+    /* Large arrays are first-touched in parallel and processed using a
+       node-aware schedule when multiple NUMA nodes are present. Otherwise,
+       the flag is a no-op. Either way, the result must be unchanged. */
+    jit_set_flag(JitFlag::NumaAffinity, 1);
+    jit_assert(jit_llvm_numa_node_count() >= 1);
+
+    uint32_t size = 1u << 22;
+    UInt32 x = arange<UInt32>(size);
+    UInt32 y = x * 2u + 1u;
+    y.eval();
+
+    for (uint32_t i = 0; i < size; i += 65537)
+        jit_assert(y.read(i) == 2 * i + 1);
+    jit_assert(y.read(size - 1) == 2 * (size - 1) + 1);
+
+    jit_set_flag(JitFlag::NumaAffinity, 0);
+}
+
+TEST_LLVM(16_cow_scatter) {
+    /* A sparse scatter into a large array that is referenced elsewhere only
+       duplicates the touched pages. Both arrays must remain independent. */
+    uint32_t size = 1u << 23;
+    UInt32 x = arange<UInt32>(size);
+    x.eval();
+
+    for (uint32_t k = 0; k < 3; ++k) {
+        UInt32 y = x;
+        scatter(y, UInt32(0), UInt32(k * 100000u));
+        jit_assert(y.read(k * 100000u) == 0u);
+        jit_assert(y.read(k * 100000u + 1) == k * 100000u + 1);
+        jit_assert(x.read(k * 100000u) == k * 100000u);
+    }
+
+    // In-place modification of the original after it was shared
+    scatter(x, UInt32(5), UInt32(size - 1));
+    UInt32 z = x;
+    scatter(z, UInt32(7), UInt32(0));
+    jit_assert(z.read(size - 1) == 5u && z.read(0) == 7u);
+    jit_assert(x.read(size - 1) == 5u && x.read(0) == 0u);
+}
+
+TEST_BOTH(17_donate_buffers) {
+    /* Update-style loops reuse the memory of the previous iteration instead
+       of allocating a new output buffer */
+    uint32_t size = 1u << 20;
+    AllocType atype =
+        Backend == JitBackend::CUDA ? AllocType::Device : AllocType::HostAsync;
+
+    jit_set_flag(JitFlag::DonateBuffers, 1);
+
+    UInt32 x = arange<UInt32>(size);
+    x.eval();
+    jit_sync_thread();
+    jit_flush_malloc_cache();
+    jit_malloc_clear_statistics();
+    size_t watermark = jit_malloc_watermark(atype);
+
+    jit_set_flag(JitFlag::KernelHistory, 1);
+    jit_kernel_history_clear();
+
+    for (uint32_t i = 0; i < 10; ++i) {
+        x = x * 3u + 1u;
+        x.eval();
+    }
+
+    // Aliasing inputs and outputs may not be declared as non-aliasing
+    KernelHistoryEntry *data = jit_kernel_history();
+    jit_set_flag(JitFlag::KernelHistory, 0);
+    for (KernelHistoryEntry *e = data; e->backend != (JitBackend) 0; ++e) {
+        if (Backend == JitBackend::LLVM && e->type == KernelType::JIT)
+            jit_assert(strstr(e->ir, "!noalias") == nullptr);
+        free(e->ir);
+    }
+    free(data);
+    jit_set_flag(JitFlag::DonateBuffers, 0);
+
+    jit_assert(jit_malloc_watermark(atype) < watermark + size * sizeof(uint32_t));
+
+    uint32_t value = 1234;
+    for (uint32_t i = 0; i < 10; ++i)
+        value = value * 3u + 1u;
+    jit_assert(x.read(1234) == value);
+
+    /* Casts that change the element size may not reuse the input buffer,
+       since blocks would overwrite inputs that other blocks still read */
+    using Float64 = Array<double>;
+    jit_set_flag(JitFlag::DonateBuffers, 1);
+    Float64 d = Float64(arange<UInt32>(size)) + .5;
+    d.eval();
+    Float f = Float(d * 2.0);
+    d = Float64();
+    f.eval();
+    jit_set_flag(JitFlag::DonateBuffers, 0);
+    jit_assert(all(eq(f, Float(arange<UInt32>(size)) * 2.f + 1.f)));
+}
+
+TEST_BOTH(18_aos_soa) {
+    struct Record {
+        float x;
+        uint32_t id;
+        uint16_t flags;
+    };
+
+    uint32_t count = 10000;
+    std::unique_ptr<Record[]> records(new Record[count]);
+    for (uint32_t i = 0; i < count; ++i)
+        records[i] = Record{ i * .5f, i * 3u, (uint16_t) (i & 0xFFFF) };
+
+    VarType types[] = { VarType::Float32, VarType::UInt32, VarType::UInt16 };
+    size_t offsets[] = { offsetof(Record, x), offsetof(Record, id),
+                         offsetof(Record, flags) };
+    uint32_t fields[3];
+    jit_aos_to_soa(Backend, records.get(), sizeof(Record), count, 3, types,
+                   offsets, fields);
+
+    Float x = Float::steal(fields[0]);
+    UInt32 id = UInt32::steal(fields[1]);
+    jit_assert(x.read(1234) == 617.f && id.read(9999) == 29997u);
+    jit_var_dec_ref(fields[2]);
+
+    // Write back modified fields, and broadcast a scalar
+    Float x_2 = x + 1.f;
+    UInt32 id_2 = 7;
+    uint32_t in[] = { x_2.index(), id_2.index() };
+    std::unique_ptr<Record[]> records_2(new Record[count]);
+    jit_assert(jit_soa_to_aos(Backend, records_2.get(), sizeof(Record), 2, in,
+                              offsets) == count);
+
+    for (uint32_t i = 0; i < count; i += 97)
+        jit_assert(records_2[i].x == i * .5f + 1.f && records_2[i].id == 7u);
+
+    // 1- and 2-byte fields, including gathers from the last entries
+    struct Small {
+        uint8_t a, pad;
+        uint16_t b;
+    };
+
+    uint32_t count_2 = 10001, last = count_2 - 1;
+    std::unique_ptr<Small[]> small(new Small[count_2]);
+    for (uint32_t i = 0; i < count_2; ++i)
+        small[i] = Small{ (uint8_t) (i * 7), 0, (uint16_t) (i * 3) };
+
+    VarType types_2[] = { VarType::UInt8, VarType::UInt16 };
+    size_t offsets_2[] = { offsetof(Small, a), offsetof(Small, b) };
+    uint32_t fields_2[2];
+    jit_aos_to_soa(Backend, small.get(), sizeof(Small), count_2, 2, types_2,
+                   offsets_2, fields_2);
+
+    using UInt8 = Array<uint8_t>;
+    using UInt16 = Array<uint16_t>;
+    UInt8 a = UInt8::steal(fields_2[0]);
+    UInt16 b = UInt16::steal(fields_2[1]);
+    jit_assert(a.size() == count_2 && b.size() == count_2);
+
+    UInt32 index(0, 1234, last - 1, last);
+    jit_assert(all(eq(UInt32(gather<UInt8>(a, index)),
+                      UInt32(0, (1234 * 7) & 0xFF, ((last - 1) * 7) & 0xFF,
+                             (last * 7) & 0xFF))));
+    jit_assert(all(eq(UInt32(gather<UInt16>(b, index)),
+                      UInt32(0, 1234 * 3, (last - 1) * 3, last * 3))));
+}
+
+#if !defined(_WIN32)
+TEST_BOTH(19_mem_map_file) {
+    const char *path = "mem_map_file.bin";
+    uint32_t count = 100000;
+
+    // A 4-byte header followed by 'count' floats
+    FILE *f = fopen(path, "wb");
+    jit_assert(f);
+    uint32_t header = 0xDEADBEEF;
+    fwrite(&header, sizeof(uint32_t), 1, f);
+    for (uint32_t i = 0; i < count; ++i) {
+        float value = (float) i;
+        fwrite(&value, sizeof(float), 1, f);
+    }
+    fclose(f);
+
+    Float x = Float::steal(jit_var_mem_map_file(Backend, path, 4,
+                                                VarType::Float32, 0));
+    jit_assert(x.size() == count && x.read(1234) == 1234.f);
+
+    UInt32 index(5, 99999, 50000);
+    jit_assert(all(eq(gather<Float>(x, index), Float(5.f, 99999.f, 50000.f))));
+
+    // In-place modifications must not reach the file
+    scatter(x, Float(-1.f), UInt32(7));
+    jit_assert(x.read(7) == -1.f);
+
+    Float y = Float::steal(jit_var_mem_map_file(Backend, path, 4 + 7 * 4,
+                                                VarType::Float32, 1));
+    jit_assert(y.read(0) == 7.f);
+
+    x = Float();
+    y = Float();
+    remove(path);
+}
+#endif
+
+TEST_BOTH(20_stream) {
+    struct Accum {
+        UInt32 sum = zero<UInt32>(1);
+        UInt32 hist = zero<UInt32>(4);
+    } accum;
+
+    StreamInput input { };
+    input.type = VarType::UInt32;
+    input.read = [](void *, size_t start, uint32_t count, void *dst) {
+        for (uint32_t i = 0; i < count; ++i)
+            ((uint32_t *) dst)[i] = (uint32_t) (start + i);
+    };
+
+    // 10 chunks, the last one is smaller
+    jit_stream(
+        Backend, 9500, 1000, 1, &input,
+        [](void *payload, size_t, uint32_t count, const uint32_t *in) {
+            Accum *a = (Accum *) payload;
+            jit_var_inc_ref(in[0]);
+            UInt32 value = UInt32::steal(in[0]);
+            jit_assert(value.size() == count);
+            scatter_reduce(ReduceOp::Add, a->sum, value, zero<UInt32>(count));
+            scatter_reduce(ReduceOp::Add, a->hist, UInt32(1), value & UInt32(3));
+        },
+        &accum);
+
+    jit_assert(accum.sum.read(0) == 9499u * 9500u / 2u);
+    jit_assert(all(eq(accum.hist, UInt32(2375u))));
+}
+
+TEST_BOTH(21_save_load) {
+    const char *path = "save_load.bin";
+
+    // Spans several chunks, the last one is partial
+    UInt32 x = arange<UInt32>(3000000) * 7u;
+    jit_var_save(x.index(), path);
+    UInt32 y = UInt32::steal(jit_var_load(path));
+    jit_assert(y.size() == x.size() && all(eq(x, y)));
+
+    // Literals are expanded
+    Float z = full<Float>(1.5f, 1000);
+    jit_var_save(z.index(), path);
+    Float w = Float::steal(jit_var_load(path));
+    jit_assert(w.size() == 1000 && w.read(999) == 1.5f);
+
+    remove(path);
+}
+
+#if defined(__linux__)
+TEST_LLVM(22_share_fd) {
+    uint32_t count = 100000;
+    Float x = arange<Float>(count) * 2.f;
+    x.eval();
+    const void *x_ptr = x.data();
+
+    int fd = -1, fd_2 = -1;
+    Float x2 = Float::steal(jit_var_export_fd(x.index(), &fd));
+    jit_assert(fd >= 0 && x2.index() != x.index() && x.data() == x_ptr);
+
+    // Exporting the shareable copy again returns it as-is
+    Float x3 = Float::steal(jit_var_export_fd(x2.index(), &fd_2));
+    jit_assert(fd_2 == fd && x3.index() == x2.index());
+
+    // Stand-in for the consuming process
+    Float y = Float::steal(
+        jit_var_import_fd(Backend, fd, VarType::Float32, count));
+    jit_assert(y.size() == count && all(eq(x, y)));
+    jit_assert(y.read(99999) == 199998.f);
+
+    // In-place modifications of the importer stay private
+    scatter(y, Float(-1.f), UInt32(7));
+    jit_assert(y.read(7) == -1.f && x2.read(7) == 14.f);
+
+    x = x2 = x3 = Float();
+    jit_assert(y.read(8) == 16.f);
+}
+#endif
+
+TEST_LLVM(23_strided_access) {
+    // Records with three interleaved fields
+    uint32_t count = 1001;
+    Float xyz = arange<Float>(3 * count);
+    UInt32 offset = arange<UInt32>(1) + 1u;
+    jit_var_eval(xyz.index());
+    jit_var_eval(offset.index());
+
+    jit_set_flag(JitFlag::KernelHistory, 1);
+    jit_kernel_history_clear();
+
+    UInt32 i = arange<UInt32>(count);
+    Float y = gather(xyz, i * 3u + offset),
+          z = gather(xyz, i + offset, i < 1000u),
+          w = zero<Float>(3 * count);
+    scatter(w, y, i * 3u + 2u);
+    jit_var_schedule(z.index());
+    jit_var_schedule(w.index());
+    jit_eval();
+
+    KernelHistoryEntry *data = jit_kernel_history();
+    jit_set_flag(JitFlag::KernelHistory, 0);
+    for (KernelHistoryEntry *e = data; e->backend != (JitBackend) 0; ++e) {
+        if (e->type == KernelType::JIT) {
+            jit_assert(strstr(e->ir, "llvm.masked.gather") == nullptr);
+            jit_assert(strstr(e->ir, "llvm.masked.scatter") == nullptr);
+        }
+        free(e->ir);
+    }
+    free(data);
+
+    jit_assert(y.read(0) == 1.f && y.read(1000) == 3001.f);
+    jit_assert(z.read(999) == 1000.f && z.read(1000) == 0.f);
+    jit_assert(w.read(2) == 1.f && w.read(3002) == 3001.f && w.read(3000) == 0.f);
+
+    // The unsigned index wraps around in masked lanes before being widened
+    Mask active = i >= 5u;
+    UInt32 j = i - 5u;
+    uint32_t j64 = jit_var_cast(j.index(), VarType::UInt64, 0);
+    Float v = Float::steal(jit_var_gather(xyz.index(), j64, active.index()));
+    jit_var_dec_ref(j64);
+    jit_assert(v.read(4) == 0.f && v.read(5) == 0.f && v.read(1000) == 995.f);
+}
+
+TEST_LLVM(24_cow_scatter_async) {
+    /* Same as 16_cow_scatter, but without synchronizing between the steps.
+       The in-place scatter into 'x' is traced before the copy-on-write
+       duplicate for 'y' was created, and must not be lost in 'z'. */
+    uint32_t size = 1u << 23;
+    UInt32 x = arange<UInt32>(size);
+    x.eval();
+
+    UInt32 y = x;
+    scatter(y, UInt32(1), UInt32(10));
+    scatter(x, UInt32(2), UInt32(20));
+    UInt32 z = x;
+    scatter(z, UInt32(3), UInt32(30));
+
+    jit_var_schedule(y.index());
+    jit_var_schedule(z.index());
+    jit_eval();
+
+    jit_assert(y.read(10) == 1u && y.read(20) == 20u && y.read(30) == 30u);
+    jit_assert(x.read(10) == 10u && x.read(20) == 2u && x.read(30) == 30u);
+    jit_assert(z.read(10) == 10u && z.read(20) == 2u && z.read(30) == 3u);
+}
+
+TEST_LLVM(25_cow_migrate) {
+    /* A copy-on-write mapping that is migrated to regular host memory keeps
+       its contents, but is no longer tracked as such */
+    uint32_t size = 1u << 23;
+    size_t bytes = size * sizeof(uint32_t);
+    uint32_t *ptr = (uint32_t *) jit_malloc(AllocType::HostAsync, bytes);
+
+    /* Scope */ {
+        UInt32 a = arange<UInt32>(size);
+        a.eval();
+        jit_memcpy(Backend, ptr, a.data(), bytes);
+
+        UInt32 x = UInt32::steal(
+            jit_var_mem_map(Backend, VarType::UInt32, ptr, size, 0));
+        UInt32 y = x;
+        scatter(y, UInt32(1), UInt32(10));
+        jit_assert(y.read(10) == 1u && x.read(10) == 10u);
+    }
+
+    log_value.clear();
+    ptr = (uint32_t *) jit_malloc_migrate(ptr, AllocType::Host, 1);
+    jit_assert(strstr(log_value.c_str(), "no longer tracking copy-on-write"));
+
+    for (uint32_t i = 0; i < size; i += 65537)
+        jit_assert(ptr[i] == i);
+    ptr[10] = 5;
+    jit_assert(ptr[10] == 5u && ptr[11] == 11u);
+    jit_free(ptr);
+}
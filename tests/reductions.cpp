@@ -1,5 +1,18 @@
 #include "test.h"
 #include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#  include <cerrno>
+#  include <cstdlib>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+
+extern char **environ;
+#endif
 
 TEST_BOTH(01_all_any) {
     using Bool = Array<bool>;
@@ -203,3 +216,169 @@ TEST_LLVM(06_parallel_scatter_reduce) {
     jit_assert(ref == a);
 }
 #endif
+
+/// Simulates a group of 3 ranks, where the other two contribute copies of 'in'
+static void replicate_allgather(const void *in, void *out, size_t size, void *) {
+    for (int i = 0; i < 3; ++i)
+        memcpy((uint8_t *) out + i * size, in, size);
+}
+
+TEST_BOTH(07_collectives) {
+    jit_shard_init(1, 3, replicate_allgather, nullptr);
+
+    size_t offset = 0;
+    jit_assert(jit_shard_slice(10, &offset) == 3 && offset == 4);
+
+    UInt32 x = arange<UInt32>(100);
+    UInt32 sum = UInt32::steal(jit_var_reduce_all(x.index(), ReduceOp::Add));
+    UInt32 max = UInt32::steal(jit_var_reduce_all(x.index(), ReduceOp::Max));
+    jit_assert(sum.read(0) == 3 * 4950 && max.read(0) == 99);
+
+    // The (single) preceding rank contributes 100 ones
+    UInt32 ones = full<UInt32>(1, 100), scan = zero<UInt32>(100);
+    jit_var_eval(ones.index());
+    uint32_t total = jit_scan_u32_all(Backend, ones.data(), 100, scan.data());
+    jit_assert(total == 300 && scan.read(0) == 100 && scan.read(99) == 199);
+
+    jit_shard_shutdown();
+    jit_assert(jit_shard_size() == 1 && jit_shard_rank() == 0);
+}
+
+TEST_LLVM(08_spmv_csr) {
+    // A long first row followed by short rows (some of them empty)
+    uint32_t rows = 5000, cols = 64;
+    std::vector<uint32_t> offsets(1, 0), col_idx;
+    std::vector<float> values, x(cols), ref(rows, 0.f);
+
+    for (uint32_t i = 0; i < cols; ++i)
+        x[i] = (float) (i % 5);
+
+    for (uint32_t i = 0; i < rows; ++i) {
+        uint32_t n = i == 0 ? 40000 : i % 7;
+        for (uint32_t j = 0; j < n; ++j) {
+            uint32_t c = (i + 3 * j) % cols;
+            float v = (float) ((i + j) % 3) - 1.f;
+            col_idx.push_back(c);
+            values.push_back(v);
+            ref[i] += v * x[c];
+        }
+        offsets.push_back((uint32_t) col_idx.size());
+    }
+
+    uint32_t nnz = (uint32_t) col_idx.size();
+    UInt32 offsets_v = UInt32::copy(offsets.data(), rows + 1),
+           cols_v = UInt32::copy(col_idx.data(), nnz);
+    Float values_v = Float::copy(values.data(), nnz),
+          x_v = Float::copy(x.data(), cols),
+          out = zero<Float>(rows);
+
+    jit_spmv_csr(Backend, VarType::Float32, offsets_v.data(), cols_v.data(),
+                 values_v.data(), x_v.data(), out.data(), rows, nnz);
+
+    std::vector<float> result(rows);
+    jit_memcpy(Backend, result.data(), out.data(), rows * sizeof(float));
+    for (uint32_t i = 0; i < rows; ++i)
+        jit_assert(result[i] == ref[i]);
+}
+
+#if defined(__linux__)
+/// Run collectives as one rank of a shared memory group, returns 'true' on success
+static bool collectives_shm_rank(const char *name, uint32_t rank) {
+    jit_shard_init_shm(name, rank, 3);
+
+    // The logical array 0, 1, .., 999 is split across the ranks
+    size_t offset = 0;
+    uint32_t n = jit_shard_slice(1000, &offset);
+    UInt32L ones = full<UInt32L>(1, n), scan = zero<UInt32L>(n);
+    jit_var_eval(ones.index());
+
+    bool success = jit_shard_rank() == rank && jit_shard_size() == 3;
+
+    // Repeated calls reuse the slots of the shared memory region
+    for (uint32_t i = 1; i <= 10; ++i) {
+        UInt32L x = (arange<UInt32L>(n) + UInt32L((uint32_t) offset)) * i;
+        jit_var_eval(x.index());
+
+        uint32_t sum = 0, max = 0;
+        jit_reduce_all(JitBackend::LLVM, VarType::UInt32, ReduceOp::Add,
+                       x.data(), n, &sum);
+        jit_reduce_all(JitBackend::LLVM, VarType::UInt32, ReduceOp::Max,
+                       x.data(), n, &max);
+        success &= sum == 499500 * i && max == 999 * i;
+
+        uint32_t total =
+            jit_scan_u32_all(JitBackend::LLVM, ones.data(), n, scan.data());
+        success &= total == 1000 && scan.read(0) == offset &&
+                   scan.read(n - 1) == offset + n - 1;
+    }
+
+    jit_shard_shutdown();
+    return success;
+}
+
+TEST_LLVM(09_collectives_shm) {
+    // Entry point of the additional ranks (see below)
+    const char *rank_env = getenv("DRJIT_TEST_SHM_RANK"),
+               *name_env = getenv("DRJIT_TEST_SHM_NAME");
+    if (rank_env && name_env) {
+        jit_assert(collectives_shm_rank(name_env, (uint32_t) atoi(rank_env)));
+        return;
+    }
+
+    char name[64], exe[1024];
+    snprintf(name, sizeof(name), "/drjit_test_shm_%i", (int) getpid());
+    ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    jit_assert(len > 0);
+    exe[len] = '\0';
+
+    /* The other ranks re-execute this test binary, since a forked copy of the
+       multithreaded parent must not use the JIT. Prepare the arguments and
+       environment up front: only async-signal-safe calls may happen between
+       fork() and exec(). */
+    std::vector<std::string> env[2];
+    std::vector<char *> envp[2];
+    char arg_l[] = "-l", arg_t[] = "-t",
+         arg_name[] = "test09_collectives_shm_llvm";
+    char *argv[] = { exe, arg_l, arg_t, arg_name, nullptr };
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        for (char **e = environ; *e; ++e)
+            env[i].push_back(*e);
+        env[i].push_back("DRJIT_TEST_SHM_RANK=" + std::to_string(i + 1));
+        env[i].push_back(std::string("DRJIT_TEST_SHM_NAME=") + name);
+        for (std::string &str : env[i])
+            envp[i].push_back((char *) str.c_str());
+        envp[i].push_back(nullptr);
+    }
+
+    pid_t pids[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        pids[i] = fork();
+        jit_assert(pids[i] >= 0);
+        if (pids[i] == 0) {
+            int fd = open("/dev/null", O_WRONLY);
+            if (fd >= 0)
+                dup2(fd, STDOUT_FILENO);
+            execve(exe, argv, envp[i].data());
+            _exit(127);
+        }
+    }
+
+    bool success = false;
+    try {
+        success = collectives_shm_rank(name, 0);
+    } catch (const std::exception &) { }
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        int status = 0;
+        jit_assert(waitpid(pids[i], &status, 0) == pids[i]);
+        success &= WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    }
+    jit_assert(success);
+
+    // The name of the shared memory object was removed once the group formed
+    errno = 0;
+    jit_assert(shm_open(name, O_RDONLY, 0600) < 0 && errno == ENOENT);
+    jit_assert(jit_shard_size() == 1 && jit_shard_rank() == 0);
+}
+#endif
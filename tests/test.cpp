@@ -288,8 +288,11 @@ int main(int argc, char **argv) {
     int log_level_stderr = (int) LogLevel::Warn;
     bool test_cuda = true, test_optix = true, test_llvm = true,
          write_ref = false, help = false;
+    const char *test_only = nullptr;
     for (int i = 1; i < argc; ++i) {
-        if (strcmp(argv[i], "-w") == 0) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            test_only = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0) {
             write_ref = true;
         } else if (strcmp(argv[i], "-v") == 0) {
             log_level_stderr = std::max((int) LogLevel::Info, log_level_stderr + 1);
@@ -320,6 +323,7 @@ int main(int argc, char **argv) {
         printf(" -l   Only run LLVM tests\n\n");
         printf(" -o   Only run OptiX tests\n\n");
         printf(" -v   Be more verbose (can be repeated)\n\n");
+        printf(" -t <name>  Only run the test with the given name\n\n");
         return 0;
     }
 
@@ -352,6 +356,9 @@ int main(int argc, char **argv) {
             tests_failed = 0;
 
         for (auto &test : *tests) {
+            if (test_only && strcmp(test.name, test_only) != 0)
+                continue;
+
             fprintf(stdout, " - %s .. ", test.name);
 
             bool is_cuda = strstr(test.name, "_cuda"),
@@ -916,3 +916,68 @@ TEST_BOTH(12_nested_with_side_effects) {
         jit_registry_trim();
     }
 }
+
+TEST_LLVM(13_devirtualize_hot_instance) {
+    /* Once jit_var_vcall_reduce() has observed that instance 1 dominates the
+       "Base" domain, later calls handle it via a guarded direct call. The
+       remaining (cold and masked) lanes must still produce correct results */
+    struct Base {
+        virtual Float f(Float x) = 0;
+    };
+
+    struct H1 : Base {
+        Float f(Float x) override { return x * 2; }
+    };
+
+    struct H2 : Base {
+        Float f(Float x) override { return x + 10; }
+    };
+
+    using BasePtr = Array<Base *>;
+
+    uint32_t ids[20];
+    for (uint32_t i = 0; i < 20; ++i)
+        ids[i] = i == 3 ? 0 : (i == 7 ? 2 : 1);
+    BasePtr self = UInt32::copy(ids, 20);
+    Float x = arange<Float>(20);
+
+    H1 h1; H2 h2;
+    uint32_t i1 = jit_registry_put(Backend, "Base", &h1);
+    uint32_t i2 = jit_registry_put(Backend, "Base", &h2);
+    jit_assert(i1 == 1 && i2 == 2);
+
+    uint32_t bucket_count = 0;
+    VCallBucket *buckets =
+        jit_var_vcall_reduce(Backend, "Base", self.index(), &bucket_count);
+    jit_assert(bucket_count >= 2 && buckets[0].id == 1);
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        jit_set_flag(JitFlag::VCallOptimize, i);
+        jit_set_flag(JitFlag::KernelHistory, 1);
+        jit_kernel_history_clear();
+
+        Float y = vcall("Base", [](Base *self2, Float x2) { return self2->f(x2); }, self, x);
+        jit_var_eval(y.index());
+
+        KernelHistoryEntry *data = jit_kernel_history();
+        jit_set_flag(JitFlag::KernelHistory, 0);
+        jit_assert(data);
+
+        // The dominant instance is only called directly when optimizing
+        bool hot = false;
+        for (KernelHistoryEntry *e = data; e->backend != (JitBackend) 0; ++e) {
+            if (e->type == KernelType::JIT)
+                hot |= strstr(e->ir, "_hot_any") && strstr(e->ir, "_hot:") &&
+                       strstr(e->ir, ") alwaysinline");
+            free(e->ir);
+        }
+        free(data);
+        jit_assert(hot == (i == 1));
+
+        jit_assert(strcmp(y.str(), "[0, 2, 4, 0, 8, 10, 12, 17, 16, 18, 20, 22, "
+                                   "24, 26, 28, 30, 32, 34, 36, 38]") == 0);
+    }
+
+    jit_registry_remove(Backend, &h1);
+    jit_registry_remove(Backend, &h2);
+}